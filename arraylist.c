@@ -14,40 +14,237 @@
  *  You should have received a copy of the GNU General Public License
  *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* mremap() */
+#endif
+#include <fcntl.h>
 #include <stdint.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include "arraylist.h"
 #include "common.h"
 
+/*
+ * vector width used by the typed search kernels. the lanes are compared with a
+ * single instruction and reduced to a byte mask, so a match of a T sized lane
+ * sets sizeof(T) consecutive bits in the mask.
+ */
+#if defined(__GNUC__) && defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_WIDTH 32
+typedef __m256i simd_vec_t;
+#define simd_load(p) _mm256_loadu_si256((const __m256i *)(p))
+#define simd_mask(v) ((u32)_mm256_movemask_epi8(v))
+#define simd_set1_u8(x) _mm256_set1_epi8((char)(x))
+#define simd_set1_u16(x) _mm256_set1_epi16((short)(x))
+#define simd_set1_u32(x) _mm256_set1_epi32((int)(x))
+#define simd_set1_u64(x) _mm256_set1_epi64x((long long)(x))
+#define simd_set1_f32(x) _mm256_castps_si256(_mm256_set1_ps(x))
+#define simd_eq_u8(a, b) _mm256_cmpeq_epi8((a), (b))
+#define simd_eq_u16(a, b) _mm256_cmpeq_epi16((a), (b))
+#define simd_eq_u32(a, b) _mm256_cmpeq_epi32((a), (b))
+#define simd_eq_u64(a, b) _mm256_cmpeq_epi64((a), (b))
+#define simd_eq_f32(a, b)                                                             \
+    _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), \
+				      _CMP_EQ_OQ))
+#elif defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_WIDTH 16
+typedef __m128i simd_vec_t;
+#define simd_load(p) _mm_loadu_si128((const __m128i *)(p))
+#define simd_mask(v) ((u32)_mm_movemask_epi8(v))
+#define simd_set1_u8(x) _mm_set1_epi8((char)(x))
+#define simd_set1_u16(x) _mm_set1_epi16((short)(x))
+#define simd_set1_u32(x) _mm_set1_epi32((int)(x))
+#define simd_set1_u64(x) _mm_set1_epi64x((long long)(x))
+#define simd_set1_f32(x) _mm_castps_si128(_mm_set1_ps(x))
+#define simd_eq_u8(a, b) _mm_cmpeq_epi8((a), (b))
+#define simd_eq_u16(a, b) _mm_cmpeq_epi16((a), (b))
+#define simd_eq_u32(a, b) _mm_cmpeq_epi32((a), (b))
+#define simd_eq_u64(a, b) simd_eq_u64_sse2((a), (b))
+#define simd_eq_f32(a, b) _mm_castps_si128(_mm_cmpeq_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)))
+
+/* sse2 has no 64-bit compare, so both 32-bit halves of a lane have to match */
+static inline __m128i simd_eq_u64_sse2(__m128i a, __m128i b)
+{
+    __m128i eq = _mm_cmpeq_epi32(a, b);
+    return _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+#endif
+
 /* arraylist implementation */
 void arraylist_init(struct arraylist_t *arr, u32 T_size)
 {
+    arr->size = 0;
+    arr->T_size = T_size;
+    arr->map = NULL;
+    arr->fd = -1;
 #ifdef DARR_STARTING_CAP
-    da->cap = DARR_STARTING_CAP;
+    arr->cap = DARR_STARTING_CAP;
+    arr->data = malloc(T_size * arr->cap);
 #else
+    /* storage is allocated on the first insert, so empty lists cost nothing */
     arr->cap = 0;
-    arr->cap = GROW_CAPACITY(arr->cap);
+    arr->data = NULL;
 #endif
+}
 
-    arr->size = 0;
+/*
+ * file backed arraylists start with this header, padded to a cache line so the
+ * elements that follow it stay aligned.
+ */
+#define ARRAYLIST_FILE_MAGIC 0x7473696c6363696eULL /* "nicclist" */
+#define ARRAYLIST_FILE_HEADER_SIZE 64
+
+struct arraylist_file_header_t {
+    u64 magic;
+    u64 T_size;
+    u64 size;
+};
+
+static size_t mapped_len(u32 T_size, size_t cap)
+{
+    return ARRAYLIST_FILE_HEADER_SIZE + (size_t)T_size * cap;
+}
+
+static bool mapped_resize(struct arraylist_t *arr, size_t new_cap)
+{
+    size_t old_len = mapped_len(arr->T_size, arr->cap);
+    size_t new_len = mapped_len(arr->T_size, new_cap);
+
+    if (ftruncate(arr->fd, (off_t)new_len) != 0)
+	return false;
+#ifdef __linux__
+    void *map = mremap(arr->map, old_len, new_len, MREMAP_MAYMOVE);
+#else
+    void *map = mmap(NULL, new_len, PROT_READ | PROT_WRITE, MAP_SHARED, arr->fd, 0);
+    if (map != MAP_FAILED)
+	munmap(arr->map, old_len);
+#endif
+    if (map == MAP_FAILED)
+	return false;
+
+    arr->map = map;
+    arr->data = (u8 *)map + ARRAYLIST_FILE_HEADER_SIZE;
+    return true;
+}
+
+static bool mapped_open(struct arraylist_t *arr, int fd, u32 T_size)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+	return false;
+
+    bool fresh = st.st_size == 0;
+    if (!fresh && (size_t)st.st_size < ARRAYLIST_FILE_HEADER_SIZE)
+	return false;
+
+    /* trailing bytes that don't make up a whole element are cut off */
+    size_t cap = fresh ? GROW_CAPACITY(0)
+		       : ((size_t)st.st_size - ARRAYLIST_FILE_HEADER_SIZE) / T_size;
+
+    /* the file is not touched until its header is known to be ours */
+    struct arraylist_file_header_t header;
+    if (!fresh) {
+	if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))
+	    return false;
+	if (header.magic != ARRAYLIST_FILE_MAGIC || header.T_size != T_size ||
+	    header.size > cap)
+	    return false;
+    }
+
+    size_t len = mapped_len(T_size, cap);
+    if ((size_t)st.st_size != len && ftruncate(fd, (off_t)len) != 0)
+	return false;
+
+    void *map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+	return false;
+
+    if (fresh) {
+	header.magic = ARRAYLIST_FILE_MAGIC;
+	header.T_size = T_size;
+	header.size = 0;
+	*(struct arraylist_file_header_t *)map = header;
+    }
+
+    arr->data = (u8 *)map + ARRAYLIST_FILE_HEADER_SIZE;
     arr->T_size = T_size;
-    arr->data = malloc(T_size * arr->cap);
+    arr->size = header.size;
+    arr->cap = cap;
+    arr->map = map;
+    arr->fd = fd;
+    return true;
+}
+
+bool arraylist_open(struct arraylist_t *arr, const char *path, u32 T_size)
+{
+    if (T_size == 0)
+	return false;
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd == -1)
+	return false;
+
+    if (!mapped_open(arr, fd, T_size)) {
+	close(fd);
+	return false;
+    }
+    return true;
+}
+
+bool arraylist_sync(struct arraylist_t *arr)
+{
+    if (arr->map == NULL)
+	return false;
+
+    ((struct arraylist_file_header_t *)arr->map)->size = arr->size;
+    return msync(arr->map, mapped_len(arr->T_size, arr->cap), MS_SYNC) == 0;
 }
 
 void arraylist_free(struct arraylist_t *arr)
 {
-    free(arr->data);
+    if (arr->map == NULL) {
+	free(arr->data);
+	return;
+    }
+
+    ((struct arraylist_file_header_t *)arr->map)->size = arr->size;
+    munmap(arr->map, mapped_len(arr->T_size, arr->cap));
+    close(arr->fd);
 }
 
-static void ensure_capacity(struct arraylist_t *arr, size_t idx)
+/* only a file backed arraylist can fail to grow, memory is realloced or we exit */
+static bool resize(struct arraylist_t *arr, size_t new_cap)
+{
+    if (arr->map != NULL) {
+	if (!mapped_resize(arr, new_cap))
+	    return false;
+    } else {
+	arr->data = nicc_internal_realloc(arr->data, arr->T_size * new_cap);
+    }
+    arr->cap = new_cap;
+    return true;
+}
+
+static bool ensure_capacity(struct arraylist_t *arr, size_t idx)
 {
     if (idx >= arr->cap) {
 	/* increase capacity */
-	arr->cap = GROW_CAPACITY(arr->cap);
-	arr->data = nicc_internal_realloc(arr->data, arr->T_size * arr->cap);
+	return resize(arr, GROW_CAPACITY(arr->cap));
     }
+    return true;
+}
+
+bool arraylist_reserve(struct arraylist_t *arr, size_t cap)
+{
+    if (cap > arr->cap)
+	return resize(arr, cap);
+    return true;
 }
 
 static void *get_element(struct arraylist_t *arr, size_t idx)
@@ -64,7 +261,8 @@ bool arraylist_set(struct arraylist_t *arr, void *val, size_t idx)
      */
     if (idx > arr->size)
 	return false;
-    ensure_capacity(arr, idx);
+    if (!ensure_capacity(arr, idx))
+	return false;
     memcpy(get_element(arr, idx), val, arr->T_size);
 
     /* special case where we actually appended to the arraylist */
@@ -121,17 +319,171 @@ bool arraylist_pop_and_copy(struct arraylist_t *arr, void *return_ptr)
     return true;
 }
 
-size_t arraylist_index_of(struct arraylist_t *arr, void *val, equality_fn_t *eq)
+enum search_mode_t {
+    SEARCH_FIRST,
+    SEARCH_COUNT,
+    SEARCH_ALL,
+};
+
+/*
+ * one scan kernel per element type. mode is always a constant at the call site,
+ * so the compiler strips the branches that are not taken. SEARCH_FIRST returns
+ * the index of the first match, the other modes return the amount of matches,
+ * and SEARCH_ALL also appends the index of every match to out.
+ */
+#ifdef SIMD_WIDTH
+#define SEARCH_SIMD_LOOP(T, SET1, EQ)                              \
+    simd_vec_t needle = SET1(val);                                 \
+    const size_t lanes = SIMD_WIDTH / sizeof(T);                   \
+    const u32 lane_bits = (1u << sizeof(T)) - 1;                   \
+    for (; i + lanes <= n; i += lanes) {                           \
+	u32 mask = simd_mask(EQ(simd_load(data + i), needle));     \
+	if (mask == 0)                                             \
+	    continue;                                              \
+	if (mode == SEARCH_FIRST)                                  \
+	    return i + (size_t)__builtin_ctz(mask) / sizeof(T);    \
+	if (mode == SEARCH_COUNT) {                                \
+	    count += (size_t)__builtin_popcount(mask) / sizeof(T); \
+	    continue;                                              \
+	}                                                          \
+	while (mask != 0) {                                        \
+	    size_t lane = (size_t)__builtin_ctz(mask) / sizeof(T); \
+	    size_t idx = i + lane;                                 \
+	    arraylist_append(out, &idx);                           \
+	    count++;                                               \
+	    mask &= ~(lane_bits << (lane * sizeof(T)));            \
+	}                                                          \
+    }
+#else
+#define SEARCH_SIMD_LOOP(T, SET1, EQ)
+#endif
+
+#define DEFINE_SEARCH(T, suffix)                                                           \
+    static inline size_t search_##suffix(const T *data, size_t n, T val,                   \
+					 enum search_mode_t mode, struct arraylist_t *out) \
+    {                                                                                      \
+	size_t i = 0;                                                                      \
+	size_t count = 0;                                                                  \
+	SEARCH_SIMD_LOOP(T, simd_set1_##suffix, simd_eq_##suffix)                          \
+	for (; i < n; i++) {                                                               \
+	    if (data[i] != val)                                                            \
+		continue;                                                                  \
+	    if (mode == SEARCH_FIRST)                                                      \
+		return i;                                                                  \
+	    if (mode == SEARCH_ALL)                                                        \
+		arraylist_append(out, &i);                                                 \
+	    count++;                                                                       \
+	}                                                                                  \
+	return mode == SEARCH_FIRST ? NICC_NOT_FOUND : count;                              \
+    }                                                                                      \
+                                                                                           \
+    size_t arraylist_index_of_##suffix(struct arraylist_t *arr, T val)                     \
+    {                                                                                      \
+	if (arr->T_size != sizeof(T))                                                      \
+	    return NICC_NOT_FOUND;                                                         \
+	return search_##suffix(arr->data, arr->size, val, SEARCH_FIRST, NULL);             \
+    }                                                                                      \
+                                                                                           \
+    size_t arraylist_count_of_##suffix(struct arraylist_t *arr, T val)                     \
+    {                                                                                      \
+	if (arr->T_size != sizeof(T))                                                      \
+	    return 0;                                                                      \
+	return search_##suffix(arr->data, arr->size, val, SEARCH_COUNT, NULL);             \
+    }                                                                                      \
+                                                                                           \
+    size_t arraylist_find_all_##suffix(struct arraylist_t *arr, T val,                     \
+				       struct arraylist_t *indices)                        \
+    {                                                                                      \
+	if (arr->T_size != sizeof(T) || indices->T_size != sizeof(size_t))                 \
+	    return 0;                                                                      \
+	return search_##suffix(arr->data, arr->size, val, SEARCH_ALL, indices);            \
+    }
+
+DEFINE_SEARCH(u8, u8)
+DEFINE_SEARCH(u16, u16)
+DEFINE_SEARCH(u32, u32)
+DEFINE_SEARCH(u64, u64)
+DEFINE_SEARCH(float, f32)
+
+/*
+ * bytewise search used when no equality function is given. elements that have
+ * the width of a machine integer go through the typed kernels.
+ */
+static size_t search_bytes(struct arraylist_t *arr, void *val, enum search_mode_t mode,
+			   struct arraylist_t *out)
 {
-    if (val == NULL)
-	return NICC_NOT_FOUND;
+    switch (arr->T_size) {
+    case 1:
+	return search_u8(arr->data, arr->size, *(u8 *)val, mode, out);
+    case 2: {
+	u16 v;
+	memcpy(&v, val, sizeof(v));
+	return search_u16(arr->data, arr->size, v, mode, out);
+    }
+    case 4: {
+	u32 v;
+	memcpy(&v, val, sizeof(v));
+	return search_u32(arr->data, arr->size, v, mode, out);
+    }
+    case 8: {
+	u64 v;
+	memcpy(&v, val, sizeof(v));
+	return search_u64(arr->data, arr->size, v, mode, out);
+    }
+    }
+
+    size_t count = 0;
     for (size_t i = 0; i < arr->size; i++) {
-	if (eq(get_element(arr, i), val)) {
+	if (!nicc_data_eq(get_element(arr, i), val, arr->T_size))
+	    continue;
+	if (mode == SEARCH_FIRST)
 	    return i;
-	}
+	if (mode == SEARCH_ALL)
+	    arraylist_append(out, &i);
+	count++;
+    }
+    return mode == SEARCH_FIRST ? NICC_NOT_FOUND : count;
+}
+
+static size_t search(struct arraylist_t *arr, void *val, equality_fn_t *eq,
+		     enum search_mode_t mode, struct arraylist_t *out)
+{
+    if (eq == NULL)
+	return search_bytes(arr, val, mode, out);
+
+    size_t count = 0;
+    for (size_t i = 0; i < arr->size; i++) {
+	if (!eq(get_element(arr, i), val))
+	    continue;
+	if (mode == SEARCH_FIRST)
+	    return i;
+	if (mode == SEARCH_ALL)
+	    arraylist_append(out, &i);
+	count++;
     }
+    return mode == SEARCH_FIRST ? NICC_NOT_FOUND : count;
+}
+
+size_t arraylist_index_of(struct arraylist_t *arr, void *val, equality_fn_t *eq)
+{
+    if (val == NULL)
+	return NICC_NOT_FOUND;
+    return search(arr, val, eq, SEARCH_FIRST, NULL);
+}
 
-    return NICC_NOT_FOUND;
+size_t arraylist_count_of(struct arraylist_t *arr, void *val, equality_fn_t *eq)
+{
+    if (val == NULL)
+	return 0;
+    return search(arr, val, eq, SEARCH_COUNT, NULL);
+}
+
+size_t arraylist_find_all(struct arraylist_t *arr, void *val, equality_fn_t *eq,
+			  struct arraylist_t *indices)
+{
+    if (val == NULL || indices->T_size != sizeof(size_t))
+	return 0;
+    return search(arr, val, eq, SEARCH_ALL, indices);
 }
 
 bool arraylist_rm(struct arraylist_t *arr, size_t idx)
@@ -139,25 +491,86 @@ bool arraylist_rm(struct arraylist_t *arr, size_t idx)
     if (idx >= arr->size)
 	return false;
 
-    for (size_t i = idx + 1; i < arr->size; i++)
-	memcpy(get_element(arr, i - 1), get_element(arr, i), arr->T_size);
+    memmove(get_element(arr, idx), get_element(arr, idx + 1), (arr->size - idx - 1) * arr->T_size);
+    arr->size--;
+    return true;
+}
+
+bool arraylist_swap_rm(struct arraylist_t *arr, size_t idx)
+{
+    if (idx >= arr->size)
+	return false;
 
     arr->size--;
+    if (idx != arr->size)
+	memcpy(get_element(arr, idx), get_element(arr, arr->size), arr->T_size);
     return true;
 }
 
+/* moves the kept run [start, end) down to write, returns the new write index */
+static size_t retain_flush(struct arraylist_t *arr, size_t write, size_t start, size_t end)
+{
+    if (write != start && end > start)
+	memmove(get_element(arr, write), get_element(arr, start), (end - start) * arr->T_size);
+    return write + (end - start);
+}
+
+size_t arraylist_retain(struct arraylist_t *arr, predicate_fn_t *pred, void *ctx)
+{
+    size_t n = arr->size;
+    size_t write = 0;
+    size_t run_start = 0;
+    bool in_run = false;
+    /* pred is called exactly once per element, in order, so it may keep state in ctx */
+    for (size_t read = 0; read < n; read++) {
+	bool keep = pred(get_element(arr, read), ctx);
+	if (keep && !in_run) {
+	    run_start = read;
+	} else if (!keep && in_run) {
+	    /* move every run of kept elements in one go */
+	    write = retain_flush(arr, write, run_start, read);
+	}
+	in_run = keep;
+    }
+    if (in_run)
+	write = retain_flush(arr, write, run_start, n);
+
+    arr->size = write;
+    return n - write;
+}
+
+size_t arraylist_dedup_sorted(struct arraylist_t *arr, equality_fn_t *eq)
+{
+    size_t n = arr->size;
+    if (n < 2)
+	return 0;
+
+    size_t write = 1;
+    for (size_t read = 1; read < n; read++) {
+	void *last = get_element(arr, write - 1);
+	void *elem = get_element(arr, read);
+	bool dup = eq == NULL ? nicc_data_eq(last, elem, arr->T_size) : eq(last, elem);
+	if (dup)
+	    continue;
+	if (write != read)
+	    memcpy(get_element(arr, write), elem, arr->T_size);
+	write++;
+    }
+
+    arr->size = write;
+    return n - write;
+}
+
 bool arraylist_rmv(struct arraylist_t *arr, void *val, equality_fn_t *eq)
 {
     if (val == NULL)
 	return false;
 
-    for (size_t i = 0; i < arr->size; i++) {
-	if (eq(get_element(arr, i), val)) {
-	    return arraylist_rm(arr, i);
-	}
-    }
+    size_t idx = arraylist_index_of(arr, val, eq);
+    if (idx == NICC_NOT_FOUND)
+	return false;
 
-    return false;
+    return arraylist_rm(arr, idx);
 }
 
 bool arraylist_sort(struct arraylist_t *arr, compare_fn_t *cmp)
@@ -171,3 +584,267 @@ bool arraylist_sort(struct arraylist_t *arr, compare_fn_t *cmp)
     qsort(arr->data, arr->size, arr->T_size, cmp);
     return true;
 }
+
+enum radix_key_t {
+    RADIX_UNSIGNED,
+    RADIX_SIGNED,
+    RADIX_FLOAT,
+};
+
+/*
+ * loads the key of an element and maps it to an unsigned integer that sorts in
+ * the same order as the original key.
+ */
+static inline u64 radix_key(const u8 *key_ptr, u32 key_size, enum radix_key_t kind)
+{
+    u64 key;
+    switch (key_size) {
+    case 1: {
+	u8 k;
+	memcpy(&k, key_ptr, sizeof(k));
+	key = k;
+	break;
+    }
+    case 2: {
+	u16 k;
+	memcpy(&k, key_ptr, sizeof(k));
+	key = k;
+	break;
+    }
+    case 4: {
+	u32 k;
+	memcpy(&k, key_ptr, sizeof(k));
+	key = k;
+	break;
+    }
+    default:
+	memcpy(&key, key_ptr, sizeof(key));
+	break;
+    }
+
+    if (kind == RADIX_UNSIGNED)
+	return key;
+
+    u64 sign_bit = (u64)1 << (key_size * 8 - 1);
+    if (kind == RADIX_SIGNED)
+	return key ^ sign_bit;
+
+    /* negative floats sort in reverse, so flip all bits, else only the sign */
+    u64 mask = key_size == 8 ? UINT64_MAX : ((u64)1 << (key_size * 8)) - 1;
+    return (key & sign_bit) ? ~key & mask : key | sign_bit;
+}
+
+static bool radix_sort(struct arraylist_t *arr, size_t key_offset, u32 key_size,
+		       enum radix_key_t kind)
+{
+    if (arr->size == 0)
+	return false;
+    if (key_size != 1 && key_size != 2 && key_size != 4 && key_size != 8)
+	return false;
+    if (kind == RADIX_FLOAT && key_size != 4 && key_size != 8)
+	return false;
+    if (key_offset + key_size > arr->T_size)
+	return false;
+
+    if (arr->size == 1)
+	return true;
+
+    size_t n = arr->size;
+    u32 T_size = arr->T_size;
+    size_t (*hist)[256] = calloc(key_size, sizeof(*hist));
+    u8 *scratch = malloc(n * T_size);
+    if (hist == NULL || scratch == NULL) {
+	free(hist);
+	free(scratch);
+	return false;
+    }
+
+    /* build the histogram of every digit in a single pass */
+    u8 *src = arr->data;
+    for (size_t i = 0; i < n; i++) {
+	u64 key = radix_key(src + i * T_size + key_offset, key_size, kind);
+	for (u32 d = 0; d < key_size; d++)
+	    hist[d][(key >> (d * 8)) & 0xff]++;
+    }
+
+    u8 *dst = scratch;
+    u64 first_key = radix_key(src + key_offset, key_size, kind);
+    for (u32 d = 0; d < key_size; d++) {
+	u32 shift = d * 8;
+	/* every element shares this digit, so the pass would not move anything */
+	if (hist[d][(first_key >> shift) & 0xff] == n)
+	    continue;
+
+	size_t offset = 0;
+	for (size_t b = 0; b < 256; b++) {
+	    size_t count = hist[d][b];
+	    hist[d][b] = offset;
+	    offset += count;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+	    u8 *elem = src + i * T_size;
+	    u64 key = radix_key(elem + key_offset, key_size, kind);
+	    memcpy(dst + hist[d][(key >> shift) & 0xff]++ * T_size, elem, T_size);
+	}
+
+	u8 *tmp = src;
+	src = dst;
+	dst = tmp;
+    }
+
+    /* an odd number of passes leaves the result in the scratch buffer */
+    if (src != arr->data)
+	memcpy(arr->data, src, n * T_size);
+
+    free(hist);
+    free(scratch);
+    return true;
+}
+
+bool arraylist_radix_sort_u(struct arraylist_t *arr, size_t key_offset, u32 key_size)
+{
+    return radix_sort(arr, key_offset, key_size, RADIX_UNSIGNED);
+}
+
+bool arraylist_radix_sort_i(struct arraylist_t *arr, size_t key_offset, u32 key_size)
+{
+    return radix_sort(arr, key_offset, key_size, RADIX_SIGNED);
+}
+
+bool arraylist_radix_sort_f(struct arraylist_t *arr, size_t key_offset, u32 key_size)
+{
+    return radix_sort(arr, key_offset, key_size, RADIX_FLOAT);
+}
+
+size_t arraylist_lower_bound(struct arraylist_t *arr, void *key, compare_fn_t *cmp)
+{
+    if (arr->size == 0)
+	return 0;
+
+    /* halve the range without branching on which half the key is in */
+    u8 *base = arr->data;
+    size_t n = arr->size;
+    while (n > 1) {
+	size_t half = n / 2;
+	base = cmp(base + half * arr->T_size, key) < 0 ? base + half * arr->T_size : base;
+	n -= half;
+    }
+
+    size_t idx = (size_t)(base - (u8 *)arr->data) / arr->T_size;
+    return idx + (cmp(base, key) < 0);
+}
+
+size_t arraylist_upper_bound(struct arraylist_t *arr, void *key, compare_fn_t *cmp)
+{
+    if (arr->size == 0)
+	return 0;
+
+    u8 *base = arr->data;
+    size_t n = arr->size;
+    while (n > 1) {
+	size_t half = n / 2;
+	base = cmp(base + half * arr->T_size, key) <= 0 ? base + half * arr->T_size : base;
+	n -= half;
+    }
+
+    size_t idx = (size_t)(base - (u8 *)arr->data) / arr->T_size;
+    return idx + (cmp(base, key) <= 0);
+}
+
+size_t arraylist_insert_sorted(struct arraylist_t *arr, void *val, compare_fn_t *cmp)
+{
+    size_t idx = arraylist_upper_bound(arr, val, cmp);
+    if (!ensure_capacity(arr, arr->size))
+	return NICC_NOT_FOUND;
+    memmove(get_element(arr, idx + 1), get_element(arr, idx), (arr->size - idx) * arr->T_size);
+    memcpy(get_element(arr, idx), val, arr->T_size);
+    arr->size++;
+    return idx;
+}
+
+#define DEFINE_BOUND(T, suffix)                                                         \
+    static inline size_t bound_##suffix(const T *data, size_t n, T key, bool upper)     \
+    {                                                                                   \
+	if (n == 0)                                                                     \
+	    return 0;                                                                   \
+	const T *base = data;                                                           \
+	while (n > 1) {                                                                 \
+	    size_t half = n / 2;                                                        \
+	    base = (upper ? base[half] <= key : base[half] < key) ? base + half : base; \
+	    n -= half;                                                                  \
+	}                                                                               \
+	return (size_t)(base - data) + (upper ? *base <= key : *base < key);            \
+    }                                                                                   \
+                                                                                        \
+    size_t arraylist_lower_bound_##suffix(struct arraylist_t *arr, T key)               \
+    {                                                                                   \
+	if (arr->T_size != sizeof(T))                                                   \
+	    return NICC_NOT_FOUND;                                                      \
+	return bound_##suffix(arr->data, arr->size, key, false);                        \
+    }                                                                                   \
+                                                                                        \
+    size_t arraylist_upper_bound_##suffix(struct arraylist_t *arr, T key)               \
+    {                                                                                   \
+	if (arr->T_size != sizeof(T))                                                   \
+	    return NICC_NOT_FOUND;                                                      \
+	return bound_##suffix(arr->data, arr->size, key, true);                         \
+    }
+
+DEFINE_BOUND(u32, u32)
+DEFINE_BOUND(u64, u64)
+DEFINE_BOUND(i32, i32)
+DEFINE_BOUND(i64, i64)
+
+/* lays out the keys by an in-order walk of the implicit tree rooted at k */
+static size_t eytzinger_fill(struct arraylist_search_index_t *index, struct arraylist_t *arr,
+			     size_t key_offset, u32 key_size, size_t i, size_t k)
+{
+    if (k > index->size)
+	return i;
+
+    i = eytzinger_fill(index, arr, key_offset, key_size, i, 2 * k);
+    u8 *elem = get_element(arr, i);
+    index->keys[k] = radix_key(elem + key_offset, key_size, RADIX_UNSIGNED);
+    index->pos[k] = i;
+    return eytzinger_fill(index, arr, key_offset, key_size, i + 1, 2 * k + 1);
+}
+
+bool arraylist_build_search_index(struct arraylist_t *arr, struct arraylist_search_index_t *index,
+				  size_t key_offset, u32 key_size)
+{
+    if (key_size != 1 && key_size != 2 && key_size != 4 && key_size != 8)
+	return false;
+    if (key_offset + key_size > arr->T_size)
+	return false;
+
+    /* aligned so that the keys prefetched together share one cache line */
+    index->keys = nicc_internal_aligned_alloc(64, (arr->size + 1) * sizeof(u64));
+    index->pos = GROW_ARRAY(size_t, NULL, arr->size + 1);
+    index->size = arr->size;
+    eytzinger_fill(index, arr, key_offset, key_size, 0, 1);
+    return true;
+}
+
+void arraylist_search_index_free(struct arraylist_search_index_t *index)
+{
+    free(index->keys);
+    free(index->pos);
+    index->keys = NULL;
+    index->pos = NULL;
+    index->size = 0;
+}
+
+size_t arraylist_search_index_lower_bound(struct arraylist_search_index_t *index, u64 key)
+{
+    size_t k = 1;
+    while (k <= index->size) {
+	/* the 8 descendants three levels down share one cache line */
+	NICC_PREFETCH(index->keys + 8 * k);
+	k = 2 * k + (index->keys[k] < key);
+    }
+
+    /* the lower bound is where the walk last went left */
+    k >>= nicc_ctz64(~(u64)k) + 1;
+    return k == 0 ? index->size : index->pos[k];
+}
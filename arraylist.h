@@ -19,6 +19,7 @@
 
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "common.h"
 
@@ -31,11 +32,37 @@ struct arraylist_t {
     u32 T_size;
     size_t size;
     size_t cap;
+    void *map; // start of the file mapping, NULL unless opened with arraylist_open()
+    int fd;
 };
 
 void arraylist_init(struct arraylist_t *arr, u32 T_size);
 void arraylist_free(struct arraylist_t *arr);
 
+/*
+ * Opens, or creates, an arraylist stored in the file at path and memory maps it.
+ * Existing elements are accessed in place without being read into memory, and
+ * growth extends the file instead of reallocating and copying. The file must
+ * have been written with the same T_size and on a machine of the same
+ * endianness. arraylist_free() unmaps and closes the file, keeping its contents.
+ * A file that is not a nicc arraylist of T_size elements is left untouched and
+ * false is returned. Growing a file backed arraylist fails, instead of exiting,
+ * if the file cannot be extended.
+ */
+bool arraylist_open(struct arraylist_t *arr, const char *path, u32 T_size);
+
+/*
+ * Persists the size of a file backed arraylist and flushes the mapping to disk.
+ * Without it the size is written on arraylist_free().
+ */
+bool arraylist_sync(struct arraylist_t *arr);
+
+/*
+ * grows the capacity to hold at least cap elements without further allocation.
+ * returns false if a file backed arraylist could not be grown.
+ */
+bool arraylist_reserve(struct arraylist_t *arr, size_t cap);
+
 bool arraylist_set(struct arraylist_t *arr, void *val, size_t idx);
 bool arraylist_append(struct arraylist_t *arr, void *val);
 
@@ -44,11 +71,200 @@ void arraylist_get_copy(struct arraylist_t *arr, size_t idx, void *return_ptr);
 bool arraylist_pop(struct arraylist_t *arr);
 bool arraylist_pop_and_copy(struct arraylist_t *arr, void *return_ptr);
 
+/*
+ * Linear search for val. If eq is NULL the elements are compared bytewise, and
+ * elements of 1, 2, 4 or 8 bytes are scanned with the typed kernels below.
+ * find_all appends the index of every match to indices, an arraylist of size_t,
+ * and returns the amount of matches.
+ */
 size_t arraylist_index_of(struct arraylist_t *arr, void *val, equality_fn_t *eq);
+size_t arraylist_count_of(struct arraylist_t *arr, void *val, equality_fn_t *eq);
+size_t arraylist_find_all(struct arraylist_t *arr, void *val, equality_fn_t *eq,
+			  struct arraylist_t *indices);
+
+/*
+ * Typed search kernels, vectorized with SSE2/AVX2 when the compiler targets it.
+ * arr->T_size must match the type, else nothing is found. Floats compare with
+ * ==, so NaN is never found and 0.0 matches -0.0.
+ */
+size_t arraylist_index_of_u8(struct arraylist_t *arr, u8 val);
+size_t arraylist_index_of_u16(struct arraylist_t *arr, u16 val);
+size_t arraylist_index_of_u32(struct arraylist_t *arr, u32 val);
+size_t arraylist_index_of_u64(struct arraylist_t *arr, u64 val);
+size_t arraylist_index_of_f32(struct arraylist_t *arr, float val);
+
+size_t arraylist_count_of_u8(struct arraylist_t *arr, u8 val);
+size_t arraylist_count_of_u16(struct arraylist_t *arr, u16 val);
+size_t arraylist_count_of_u32(struct arraylist_t *arr, u32 val);
+size_t arraylist_count_of_u64(struct arraylist_t *arr, u64 val);
+size_t arraylist_count_of_f32(struct arraylist_t *arr, float val);
+
+size_t arraylist_find_all_u8(struct arraylist_t *arr, u8 val, struct arraylist_t *indices);
+size_t arraylist_find_all_u16(struct arraylist_t *arr, u16 val, struct arraylist_t *indices);
+size_t arraylist_find_all_u32(struct arraylist_t *arr, u32 val, struct arraylist_t *indices);
+size_t arraylist_find_all_u64(struct arraylist_t *arr, u64 val, struct arraylist_t *indices);
+size_t arraylist_find_all_f32(struct arraylist_t *arr, float val, struct arraylist_t *indices);
 
 bool arraylist_rm(struct arraylist_t *arr, size_t idx);
+/* O(1) removal that moves the last element into idx, so order is not kept */
+bool arraylist_swap_rm(struct arraylist_t *arr, size_t idx);
+/* removes the first occurrence of val, see arraylist_index_of() for eq */
 bool arraylist_rmv(struct arraylist_t *arr, void *val, equality_fn_t *eq);
 
+/*
+ * Single pass compaction keeping the order of the remaining elements. retain
+ * keeps the elements pred returns true for, dedup_sorted collapses runs of
+ * equal elements into the first of them (bytewise if eq is NULL). Both return
+ * the amount of removed elements.
+ */
+size_t arraylist_retain(struct arraylist_t *arr, predicate_fn_t *pred, void *ctx);
+size_t arraylist_dedup_sorted(struct arraylist_t *arr, equality_fn_t *eq);
+
 bool arraylist_sort(struct arraylist_t *arr, compare_fn_t *cmp);
+/* selection without a full sort is arraylist_nth_element() and friends in sort.h */
+
+/*
+ * Stable LSD radix sort on a fixed-width key stored key_offset bytes into every
+ * element. key_size must be 1, 2, 4 or 8, or 4 or 8 for the float variant.
+ * Needs a scratch buffer of arr->size elements, but no comparator calls.
+ */
+bool arraylist_radix_sort_u(struct arraylist_t *arr, size_t key_offset, u32 key_size);
+bool arraylist_radix_sort_i(struct arraylist_t *arr, size_t key_offset, u32 key_size);
+bool arraylist_radix_sort_f(struct arraylist_t *arr, size_t key_offset, u32 key_size);
+
+/*
+ * Binary search over an arraylist sorted by cmp, where cmp is called with an
+ * element as its first argument and key as its second. lower_bound returns the
+ * index of the first element not less than key, upper_bound the first element
+ * greater than key, and both return arr->size if there is no such element.
+ * insert_sorted inserts val after any equal elements and returns its index, or
+ * NICC_NOT_FOUND if a file backed arraylist could not be grown.
+ */
+size_t arraylist_lower_bound(struct arraylist_t *arr, void *key, compare_fn_t *cmp);
+size_t arraylist_upper_bound(struct arraylist_t *arr, void *key, compare_fn_t *cmp);
+size_t arraylist_insert_sorted(struct arraylist_t *arr, void *val, compare_fn_t *cmp);
+
+/* branchless binary search over arraylists of the given type, sorted ascending */
+size_t arraylist_lower_bound_u32(struct arraylist_t *arr, u32 key);
+size_t arraylist_lower_bound_u64(struct arraylist_t *arr, u64 key);
+size_t arraylist_lower_bound_i32(struct arraylist_t *arr, i32 key);
+size_t arraylist_lower_bound_i64(struct arraylist_t *arr, i64 key);
+size_t arraylist_upper_bound_u32(struct arraylist_t *arr, u32 key);
+size_t arraylist_upper_bound_u64(struct arraylist_t *arr, u64 key);
+size_t arraylist_upper_bound_i32(struct arraylist_t *arr, i32 key);
+size_t arraylist_upper_bound_i64(struct arraylist_t *arr, i64 key);
+
+/*
+ * Read-only search index over an arraylist sorted on an unsigned key of
+ * key_size (1, 2, 4 or 8) bytes stored key_offset bytes into every element.
+ * The keys are copied out in Eytzinger (breadth-first) order, so a lookup walks
+ * down the array without branching on the comparison and can prefetch the
+ * cache line holding the next levels. The index has to be rebuilt after the
+ * arraylist is modified.
+ */
+struct arraylist_search_index_t {
+    u64 *keys; // 1-indexed, keys[0] is unused
+    size_t *pos; // position in the arraylist of keys[i]
+    size_t size;
+};
+
+bool arraylist_build_search_index(struct arraylist_t *arr, struct arraylist_search_index_t *index,
+				  size_t key_offset, u32 key_size);
+void arraylist_search_index_free(struct arraylist_search_index_t *index);
+
+/* same semantics as arraylist_lower_bound() on the indexed arraylist */
+size_t arraylist_search_index_lower_bound(struct arraylist_search_index_t *index, u64 key);
+
+/*
+ * Generates a typed dynamic array `struct name` holding values of T, with
+ * static inline name_init/free/get/set/append/pop operating on T directly.
+ *
+ * The first INLINE_N (> 0) elements live inside the struct itself, so a list
+ * that never grows beyond that never allocates. Past that the elements are
+ * moved to the heap and the inline storage is reused for the heap pointer.
+ * Pointers returned by name_get() are invalidated by growth and, while the
+ * list is still inline, by copying the struct.
+ *
+ * NICC_ARRAYLIST_DEFINE(intlist, int, 4)
+ * struct intlist list;
+ * intlist_init(&list);
+ * intlist_append(&list, 42);
+ */
+#define NICC_ARRAYLIST_DEFINE(name, T, INLINE_N)                        \
+    struct name {                                                       \
+	size_t size;                                                    \
+	size_t cap;                                                     \
+	union {                                                         \
+	    T *heap;                                                    \
+	    T inline_buf[INLINE_N];                                     \
+	} u;                                                            \
+    };                                                                  \
+                                                                        \
+    static inline void name##_init(struct name *arr)                    \
+    {                                                                   \
+	arr->size = 0;                                                  \
+	arr->cap = (INLINE_N);                                          \
+    }                                                                   \
+                                                                        \
+    static inline void name##_free(struct name *arr)                    \
+    {                                                                   \
+	if (arr->cap > (INLINE_N))                                      \
+	    free(arr->u.heap);                                          \
+    }                                                                   \
+                                                                        \
+    static inline T *name##_data(struct name *arr)                      \
+    {                                                                   \
+	return arr->cap > (INLINE_N) ? arr->u.heap : arr->u.inline_buf; \
+    }                                                                   \
+                                                                        \
+    static inline void name##_grow(struct name *arr)                    \
+    {                                                                   \
+	size_t new_cap = arr->cap * 2;                                  \
+	if (arr->cap > (INLINE_N)) {                                    \
+	    arr->u.heap = GROW_ARRAY(T, arr->u.heap, new_cap);          \
+	} else {                                                        \
+	    /* leaving the inline storage */                            \
+	    T *heap = GROW_ARRAY(T, NULL, new_cap);                     \
+	    memcpy(heap, arr->u.inline_buf, sizeof(T) * arr->size);     \
+	    arr->u.heap = heap;                                         \
+	}                                                               \
+	arr->cap = new_cap;                                             \
+    }                                                                   \
+                                                                        \
+    static inline T *name##_get(struct name *arr, size_t idx)           \
+    {                                                                   \
+	if (idx >= arr->size)                                           \
+	    return NULL;                                                \
+	return name##_data(arr) + idx;                                  \
+    }                                                                   \
+                                                                        \
+    static inline bool name##_set(struct name *arr, T val, size_t idx)  \
+    {                                                                   \
+	if (idx > arr->size)                                            \
+	    return false;                                               \
+	if (idx == arr->cap)                                            \
+	    name##_grow(arr);                                           \
+	name##_data(arr)[idx] = val;                                    \
+	if (idx == arr->size)                                           \
+	    arr->size++;                                                \
+	return true;                                                    \
+    }                                                                   \
+                                                                        \
+    static inline void name##_append(struct name *arr, T val)           \
+    {                                                                   \
+	if (arr->size == arr->cap)                                      \
+	    name##_grow(arr);                                           \
+	name##_data(arr)[arr->size++] = val;                            \
+    }                                                                   \
+                                                                        \
+    static inline bool name##_pop(struct name *arr, T *return_ptr)      \
+    {                                                                   \
+	if (arr->size == 0)                                             \
+	    return false;                                               \
+	arr->size--;                                                    \
+	if (return_ptr != NULL)                                         \
+	    *return_ptr = name##_data(arr)[arr->size];                  \
+	return true;                                                    \
+    }
 
 #endif /* NICC_ARRAYLIST_H */
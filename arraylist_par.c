@@ -0,0 +1,229 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand, Callum Gran
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdatomic.h>
+#include <string.h>
+
+#include "arraylist.h"
+#include "arraylist_par.h"
+#include "common.h"
+#include "threadpool.h"
+
+/*
+ * every helper is a loop over blocks. the block handler is called for every
+ * block index, and the workers pull the next block from a shared counter.
+ */
+typedef void block_fn_t(void *ctx, size_t block, size_t start, size_t end);
+
+struct par_job_t {
+    atomic_size_t next_block;
+    size_t n_blocks;
+    size_t n;
+    block_fn_t *fn;
+    void *ctx;
+};
+
+static void par_worker(void *ctx, u32 worker_id)
+{
+    (void)worker_id;
+    struct par_job_t *job = ctx;
+    size_t block;
+    while ((block = atomic_fetch_add(&job->next_block, 1)) < job->n_blocks) {
+	size_t start = block * ARRAYLIST_PAR_BLOCK;
+	size_t end = start + ARRAYLIST_PAR_BLOCK < job->n ? start + ARRAYLIST_PAR_BLOCK : job->n;
+	job->fn(job->ctx, block, start, end);
+    }
+}
+
+static size_t n_blocks(size_t n)
+{
+    return (n + ARRAYLIST_PAR_BLOCK - 1) / ARRAYLIST_PAR_BLOCK;
+}
+
+static void par_run(struct threadpool_t *pool, size_t n, block_fn_t *fn, void *ctx)
+{
+    struct par_job_t job = { .n_blocks = n_blocks(n), .n = n, .fn = fn, .ctx = ctx };
+    atomic_init(&job.next_block, 0);
+
+    if (pool == NULL || job.n_blocks < 2)
+	par_worker(&job, 0);
+    else
+	threadpool_run(pool, par_worker, &job);
+}
+
+static inline void *elem_at(struct arraylist_t *arr, size_t idx)
+{
+    return (u8 *)arr->data + idx * arr->T_size;
+}
+
+/* for each */
+struct each_ctx_t {
+    struct arraylist_t *arr;
+    par_each_fn_t *fn;
+    void *ctx;
+};
+
+static void each_block(void *ctx, size_t block, size_t start, size_t end)
+{
+    (void)block;
+    struct each_ctx_t *c = ctx;
+    for (size_t i = start; i < end; i++)
+	c->fn(elem_at(c->arr, i), c->ctx);
+}
+
+void arraylist_par_for_each(struct threadpool_t *pool, struct arraylist_t *arr, par_each_fn_t *fn,
+			    void *ctx)
+{
+    struct each_ctx_t c = { .arr = arr, .fn = fn, .ctx = ctx };
+    par_run(pool, arr->size, each_block, &c);
+}
+
+/* map */
+struct map_ctx_t {
+    struct arraylist_t *src;
+    struct arraylist_t *dst;
+    par_map_fn_t *fn;
+    void *ctx;
+};
+
+static void map_block(void *ctx, size_t block, size_t start, size_t end)
+{
+    (void)block;
+    struct map_ctx_t *c = ctx;
+    for (size_t i = start; i < end; i++)
+	c->fn(elem_at(c->src, i), elem_at(c->dst, i), c->ctx);
+}
+
+bool arraylist_par_map(struct threadpool_t *pool, struct arraylist_t *src, struct arraylist_t *dst,
+		       par_map_fn_t *fn, void *ctx)
+{
+    /* the workers write straight into dst, so it has to fit every element first */
+    if (!arraylist_reserve(dst, src->size))
+	return false;
+    dst->size = src->size;
+
+    struct map_ctx_t c = { .src = src, .dst = dst, .fn = fn, .ctx = ctx };
+    par_run(pool, src->size, map_block, &c);
+    return true;
+}
+
+/* filter */
+struct filter_ctx_t {
+    struct arraylist_t *src;
+    struct arraylist_t *dst;
+    predicate_fn_t *pred;
+    void *ctx;
+    u8 *keep; // result of pred for every element, so it is only called once
+    size_t *offsets; // kept elements per block, then the prefix sum of that
+    size_t dst_start;
+};
+
+static void filter_count_block(void *ctx, size_t block, size_t start, size_t end)
+{
+    struct filter_ctx_t *c = ctx;
+    size_t count = 0;
+    for (size_t i = start; i < end; i++) {
+	c->keep[i] = c->pred(elem_at(c->src, i), c->ctx);
+	count += c->keep[i];
+    }
+    c->offsets[block] = count;
+}
+
+static void filter_copy_block(void *ctx, size_t block, size_t start, size_t end)
+{
+    struct filter_ctx_t *c = ctx;
+    size_t out = c->dst_start + c->offsets[block];
+    for (size_t i = start; i < end; i++) {
+	if (c->keep[i])
+	    memcpy(elem_at(c->dst, out++), elem_at(c->src, i), c->src->T_size);
+    }
+}
+
+bool arraylist_par_filter(struct threadpool_t *pool, struct arraylist_t *src,
+			  struct arraylist_t *dst, predicate_fn_t *pred, void *ctx)
+{
+    if (src->size == 0)
+	return true;
+
+    struct filter_ctx_t c = { .src = src, .dst = dst, .pred = pred, .ctx = ctx };
+    c.keep = GROW_ARRAY(u8, NULL, src->size);
+    c.offsets = GROW_ARRAY(size_t, NULL, n_blocks(src->size));
+
+    par_run(pool, src->size, filter_count_block, &c);
+
+    /* exclusive prefix sum gives every block the position of its first output */
+    size_t total = 0;
+    for (size_t b = 0; b < n_blocks(src->size); b++) {
+	size_t count = c.offsets[b];
+	c.offsets[b] = total;
+	total += count;
+    }
+
+    c.dst_start = dst->size;
+    bool ok = arraylist_reserve(dst, dst->size + total);
+    if (ok) {
+	par_run(pool, src->size, filter_copy_block, &c);
+	dst->size += total;
+    }
+
+    free(c.keep);
+    free(c.offsets);
+    return ok;
+}
+
+/* reduce */
+struct reduce_ctx_t {
+    struct arraylist_t *arr;
+    u8 *accs; // one accumulator per block
+    const void *identity;
+    u32 acc_size;
+    par_reduce_fn_t *reduce;
+    void *ctx;
+};
+
+static void reduce_block(void *ctx, size_t block, size_t start, size_t end)
+{
+    struct reduce_ctx_t *c = ctx;
+    u8 *acc = c->accs + block * c->acc_size;
+    memcpy(acc, c->identity, c->acc_size);
+    for (size_t i = start; i < end; i++)
+	c->reduce(acc, elem_at(c->arr, i), c->ctx);
+}
+
+void arraylist_par_reduce(struct threadpool_t *pool, struct arraylist_t *arr, void *acc,
+			  u32 acc_size, par_reduce_fn_t *reduce, par_combine_fn_t *combine,
+			  void *ctx)
+{
+    if (arr->size == 0)
+	return;
+
+    size_t blocks = n_blocks(arr->size);
+    struct reduce_ctx_t c = {
+	.arr = arr,
+	.accs = GROW_ARRAY(u8, NULL, blocks * acc_size),
+	.identity = acc,
+	.acc_size = acc_size,
+	.reduce = reduce,
+	.ctx = ctx,
+    };
+    par_run(pool, arr->size, reduce_block, &c);
+
+    /* acc still holds the identity, so combining every block into it is safe */
+    for (size_t b = 0; b < blocks; b++)
+	combine(acc, c.accs + b * acc_size, ctx);
+
+    free(c.accs);
+}
@@ -0,0 +1,71 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand, Callum Gran
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef NICC_ARRAYLIST_PAR_H
+#define NICC_ARRAYLIST_PAR_H
+
+#include "arraylist.h"
+#include "common.h"
+#include "threadpool.h"
+
+/*
+ * Data parallel helpers over arraylist_t.
+ * The elements are split into blocks of ARRAYLIST_PAR_BLOCK elements which the
+ * workers of the pool grab one at a time, so uneven work per element still
+ * spreads out evenly. If pool is NULL everything runs on the calling thread.
+ * The callbacks are called concurrently and must not modify the arraylists.
+ */
+#ifndef ARRAYLIST_PAR_BLOCK
+#define ARRAYLIST_PAR_BLOCK 4096
+#endif
+
+typedef void par_each_fn_t(void *elem, void *ctx);
+typedef void par_map_fn_t(const void *in, void *out, void *ctx);
+/* folds elem into acc */
+typedef void par_reduce_fn_t(void *acc, const void *elem, void *ctx);
+/* folds the accumulator other into acc */
+typedef void par_combine_fn_t(void *acc, const void *other, void *ctx);
+
+void arraylist_par_for_each(struct threadpool_t *pool, struct arraylist_t *arr, par_each_fn_t *fn,
+			    void *ctx);
+
+/*
+ * Sets dst to fn applied to every element of src. dst must be initialized with
+ * the T_size of the output type and is resized to hold src->size elements.
+ * returns false, before fn is called, if dst could not be grown.
+ */
+bool arraylist_par_map(struct threadpool_t *pool, struct arraylist_t *src, struct arraylist_t *dst,
+		       par_map_fn_t *fn, void *ctx);
+
+/*
+ * Appends the elements of src that pred returns true for to dst, in their
+ * original order. dst must have the same T_size as src. returns false, with dst
+ * unchanged, if dst could not be grown to hold the kept elements.
+ */
+bool arraylist_par_filter(struct threadpool_t *pool, struct arraylist_t *src,
+			  struct arraylist_t *dst, predicate_fn_t *pred, void *ctx);
+
+/*
+ * Reduces arr into acc, which holds acc_size bytes and must be the identity of
+ * the reduction when called. Every block is reduced into its own copy of the
+ * identity and the blocks are combined in order, so the reduction has to be
+ * associative; it need not be commutative.
+ */
+void arraylist_par_reduce(struct threadpool_t *pool, struct arraylist_t *arr, void *acc,
+			  u32 acc_size, par_reduce_fn_t *reduce, par_combine_fn_t *combine,
+			  void *ctx);
+
+#endif /* NICC_ARRAYLIST_PAR_H */
@@ -16,9 +16,18 @@
  */
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include "common.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define NICC_AVX2_DISPATCH
+#endif
+
+/* elements at least this large go through the widest kernel the cpu supports */
+#define WIDE_KERNEL_MIN 64
+
 void *nicc_internal_realloc(void *ptr, size_t new_size)
 {
     void *res = realloc(ptr, new_size);
@@ -29,17 +38,187 @@ void *nicc_internal_realloc(void *ptr, size_t new_size)
     return res;
 }
 
-bool nicc_data_eq(void *a, void *b, u32 T_size)
+void *nicc_internal_aligned_alloc(size_t alignment, size_t size)
 {
-    /* bytewise comparison */
-    u8 A;
-    u8 B;
-    for (size_t i = 0; i < (size_t)T_size; i++) {
-        A = ((u8 *)a)[i];
-        B = ((u8 *)b)[i];
-        if (A != B)
-            return false;
+    size = (size + alignment - 1) & ~(alignment - 1);
+    void *res = aligned_alloc(alignment, size);
+    if (res == NULL)
+	exit(1);
+
+    return res;
+}
+
+/*
+ * unaligned word loads and stores. memcpy of a constant size compiles down to a
+ * single move, so these cost the same as a plain dereference.
+ */
+static inline u64 load64(const u8 *p)
+{
+    u64 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store64(u8 *p, u64 v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline u32 load32(const u8 *p)
+{
+    u32 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store32(u8 *p, u32 v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+/* word-at-a-time kernels, used for odd sizes and as the tail of the wide kernels */
+static bool data_eq_words(const u8 *a, const u8 *b, size_t size)
+{
+    for (; size >= 8; a += 8, b += 8, size -= 8) {
+	if (load64(a) != load64(b))
+	    return false;
+    }
+    if (size >= 4) {
+	if (load32(a) != load32(b))
+	    return false;
+	a += 4;
+	b += 4;
+	size -= 4;
+    }
+    for (size_t i = 0; i < size; i++) {
+	if (a[i] != b[i])
+	    return false;
     }
     return true;
 }
 
+static void data_swap_words(u8 *a, u8 *b, size_t size)
+{
+    for (; size >= 8; a += 8, b += 8, size -= 8) {
+	u64 tmp = load64(a);
+	store64(a, load64(b));
+	store64(b, tmp);
+    }
+    if (size >= 4) {
+	u32 tmp = load32(a);
+	store32(a, load32(b));
+	store32(b, tmp);
+	a += 4;
+	b += 4;
+	size -= 4;
+    }
+    for (size_t i = 0; i < size; i++) {
+	u8 tmp = a[i];
+	a[i] = b[i];
+	b[i] = tmp;
+    }
+}
+
+#ifdef NICC_AVX2_DISPATCH
+__attribute__((target("avx2"))) static bool data_eq_avx2(const u8 *a, const u8 *b, size_t size)
+{
+    for (; size >= 32; a += 32, b += 32, size -= 32) {
+	__m256i x = _mm256_loadu_si256((const __m256i *)a);
+	__m256i y = _mm256_loadu_si256((const __m256i *)b);
+	if ((u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)) != 0xffffffffu)
+	    return false;
+    }
+    return data_eq_words(a, b, size);
+}
+
+__attribute__((target("avx2"))) static void data_swap_avx2(u8 *a, u8 *b, size_t size)
+{
+    for (; size >= 32; a += 32, b += 32, size -= 32) {
+	__m256i x = _mm256_loadu_si256((const __m256i *)a);
+	__m256i y = _mm256_loadu_si256((const __m256i *)b);
+	_mm256_storeu_si256((__m256i *)a, y);
+	_mm256_storeu_si256((__m256i *)b, x);
+    }
+    data_swap_words(a, b, size);
+}
+#endif
+
+static bool (*data_eq_wide)(const u8 *, const u8 *, size_t) = data_eq_words;
+static void (*data_swap_wide)(u8 *, u8 *, size_t) = data_swap_words;
+
+#ifdef NICC_AVX2_DISPATCH
+/* pick the wide kernels once at load time instead of checking cpuid on every call */
+__attribute__((constructor)) static void select_kernels(void)
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+	data_eq_wide = data_eq_avx2;
+	data_swap_wide = data_swap_avx2;
+    }
+}
+#endif
+
+bool nicc_data_eq(const void *a, const void *b, u32 T_size)
+{
+    const u8 *A = a;
+    const u8 *B = b;
+    switch (T_size) {
+    case 4:
+	return load32(A) == load32(B);
+    case 8:
+	return load64(A) == load64(B);
+    case 16:
+	return ((load64(A) ^ load64(B)) | (load64(A + 8) ^ load64(B + 8))) == 0;
+    case 32:
+	return ((load64(A) ^ load64(B)) | (load64(A + 8) ^ load64(B + 8)) |
+		(load64(A + 16) ^ load64(B + 16)) | (load64(A + 24) ^ load64(B + 24))) == 0;
+    }
+
+    if (T_size >= WIDE_KERNEL_MIN)
+	return data_eq_wide(A, B, T_size);
+    return data_eq_words(A, B, T_size);
+}
+
+void nicc_data_swap(void *a, void *b, size_t size)
+{
+    /* sorts swap an element with itself, which memcpy must not be given */
+    if (a == b)
+	return;
+
+    u8 *A = a;
+    u8 *B = b;
+    switch (size) {
+    case 4: {
+	u32 tmp = load32(A);
+	store32(A, load32(B));
+	store32(B, tmp);
+	return;
+    }
+    case 8: {
+	u64 tmp = load64(A);
+	store64(A, load64(B));
+	store64(B, tmp);
+	return;
+    }
+    case 16: {
+	/* fixed size copies through a temporary become a pair of vector moves */
+	u8 tmp[16];
+	memcpy(tmp, A, 16);
+	memcpy(A, B, 16);
+	memcpy(B, tmp, 16);
+	return;
+    }
+    case 32: {
+	u8 tmp[32];
+	memcpy(tmp, A, 32);
+	memcpy(A, B, 32);
+	memcpy(B, tmp, 32);
+	return;
+    }
+    }
+
+    if (size >= WIDE_KERNEL_MIN)
+	data_swap_wide(A, B, size);
+    else
+	data_swap_words(A, B, size);
+}
@@ -18,24 +18,37 @@
 #define NICC_COMMON_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 
 #ifndef u8
 #define u8 uint8_t
 #endif
+#ifndef u16
+#define u16 uint16_t
+#endif
 #ifndef u32
 #define u32 uint32_t
 #endif
+#ifndef u64
+#define u64 uint64_t
+#endif
 
 #ifndef i32
 #define i32 int32_t
 #endif
+#ifndef i64
+#define i64 int64_t
+#endif
 
 #ifndef NICC_NOT_FOUND
 #define NICC_NOT_FOUND SIZE_MAX
 #endif
 
+/* pointer to the struct of the given type that embeds member at ptr */
+#define NICC_CONTAINER_OF(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+
 #define GROW_CAPACITY(capacity) ((capacity) < 8 ? 8 : (capacity)*2)
 
 #define GROW_ARRAY(type, pointer, new_size) \
@@ -43,24 +56,62 @@
 
 /* internal function definitions */
 void *nicc_internal_realloc(void *ptr, size_t new_size);
+/* aligned_alloc() that rounds size up to alignment and, like realloc above, never returns NULL */
+void *nicc_internal_aligned_alloc(size_t alignment, size_t size);
+
+/*
+ * element compare and swap kernels. 4, 8, 16 and 32 byte elements take
+ * specialized paths, large elements use the widest vector unit the cpu has.
+ * copies just use memcpy, which the compiler inlines for constant sizes and
+ * libc already vectorizes with its own cpu dispatch.
+ */
+bool nicc_data_eq(const void *a, const void *b, u32 T_size);
 
-bool nicc_data_eq(void *a, void *b, u32 T_size);
+/* a and b are either the same object or do not overlap */
+void nicc_data_swap(void *a, void *b, size_t size);
 
 typedef i32 compare_fn_t(const void *, const void *);
 
 typedef bool equality_fn_t(const void *, const void *);
 
+/* called with an element and the ctx pointer given by the caller */
+typedef bool predicate_fn_t(const void *, void *);
+
+#if defined(__GNUC__)
+#define NICC_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define NICC_PREFETCH(addr) ((void)(addr))
+#endif
+
+/* count trailing and leading zero bits. x must not be 0 */
+static inline u32 nicc_ctz64(u64 x)
+{
+#if defined(__GNUC__)
+    return (u32)__builtin_ctzll(x);
+#else
+    u32 n = 0;
+    while (!(x & 1)) {
+	x >>= 1;
+	n++;
+    }
+    return n;
+#endif
+}
+
+static inline u32 nicc_clz64(u64 x)
+{
+#if defined(__GNUC__)
+    return (u32)__builtin_clzll(x);
+#else
+    u32 n = 0;
+    while (!(x & ((u64)1 << 63))) {
+	x <<= 1;
+	n++;
+    }
+    return n;
+#endif
+}
 
-#define BYTE_SWAP(a, b, size)                    \
-    do {                                         \
-	size_t __size = (size);                  \
-	register unsigned char *__a = (a);       \
-	register unsigned char *__b = (b);       \
-	do {                                     \
-	    register unsigned char __tmp = *__a; \
-	    *__a++ = *__b;                       \
-	    *__b++ = __tmp;                      \
-	} while (--__size > 0);                  \
-    } while (0)
+#define BYTE_SWAP(a, b, size) nicc_data_swap((a), (b), (size))
 
 #endif /* NICC_COMMON_H */
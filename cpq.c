@@ -0,0 +1,163 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+
+#include "common.h"
+#include "cpq.h"
+#include "heapq.h"
+
+#define EMPTY_KEY UINT64_MAX
+
+/* per thread xorshift state, seeded from its own address on first use */
+static _Thread_local u64 rng_state;
+
+static u32 random_shard(struct cpq_t *q)
+{
+    if (rng_state == 0)
+	rng_state = (u64)(uintptr_t)&rng_state | 1;
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    /* multiply-shift maps the random bits onto [0, n_shards) without a division */
+    return (u32)(((rng_state >> 32) * q->n_shards) >> 32);
+}
+
+/* must hold the lock of the shard */
+static void update_top_key(struct cpq_shard_t *shard)
+{
+    u64 top = shard->heap.size > 0 ? heapq_top_key(&shard->heap) : EMPTY_KEY;
+    atomic_store_explicit(&shard->top_key, top, memory_order_relaxed);
+}
+
+/* must hold the lock of a non-empty shard */
+static void pop_locked(struct cpq_t *q, struct cpq_shard_t *shard, void **item, u64 *key)
+{
+    if (key != NULL)
+	*key = heapq_top_key(&shard->heap);
+    heapq_pop_copy(&shard->heap, item);
+    update_top_key(shard);
+    atomic_fetch_sub_explicit(&q->size, 1, memory_order_relaxed);
+}
+
+void cpq_init(struct cpq_t *q, enum cpq_mode_t mode, u32 n_threads)
+{
+    if (n_threads == 0)
+	n_threads = 1;
+    q->n_shards = mode == CPQ_STRICT ? 1 : n_threads * CPQ_SHARDS_PER_THREAD;
+    q->shards = nicc_internal_aligned_alloc(_Alignof(struct cpq_shard_t),
+					    q->n_shards * sizeof(struct cpq_shard_t));
+    atomic_init(&q->size, 0);
+
+    for (u32 i = 0; i < q->n_shards; i++) {
+	struct cpq_shard_t *shard = &q->shards[i];
+	pthread_mutex_init(&shard->lock, NULL);
+	heapq_init_copy(&shard->heap, sizeof(void *), NULL);
+	atomic_init(&shard->top_key, EMPTY_KEY);
+    }
+}
+
+void cpq_free(struct cpq_t *q)
+{
+    for (u32 i = 0; i < q->n_shards; i++) {
+	pthread_mutex_destroy(&q->shards[i].lock);
+	heapq_free(&q->shards[i].heap);
+    }
+    free(q->shards);
+}
+
+static struct cpq_shard_t *lock_push_shard(struct cpq_t *q)
+{
+    if (q->n_shards == 1) {
+	pthread_mutex_lock(&q->shards[0].lock);
+	return &q->shards[0];
+    }
+
+    /* on a busy shard try another one, any of them will do */
+    for (u32 tries = 0; tries < q->n_shards; tries++) {
+	struct cpq_shard_t *shard = &q->shards[random_shard(q)];
+	if (pthread_mutex_trylock(&shard->lock) == 0)
+	    return shard;
+    }
+
+    struct cpq_shard_t *shard = &q->shards[random_shard(q)];
+    pthread_mutex_lock(&shard->lock);
+    return shard;
+}
+
+void cpq_push(struct cpq_t *q, void *item, u64 key)
+{
+    struct cpq_shard_t *shard = lock_push_shard(q);
+    heapq_push_copy_key(&shard->heap, &item, key);
+    update_top_key(shard);
+    atomic_fetch_add_explicit(&q->size, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&shard->lock);
+}
+
+/* locks the shards one by one and pops from the first non-empty one */
+static bool pop_any(struct cpq_t *q, void **item, u64 *key)
+{
+    u32 start = random_shard(q);
+    for (u32 i = 0; i < q->n_shards; i++) {
+	struct cpq_shard_t *shard = &q->shards[(start + i) % q->n_shards];
+	pthread_mutex_lock(&shard->lock);
+	if (shard->heap.size > 0) {
+	    pop_locked(q, shard, item, key);
+	    pthread_mutex_unlock(&shard->lock);
+	    return true;
+	}
+	pthread_mutex_unlock(&shard->lock);
+    }
+    return false;
+}
+
+bool cpq_pop(struct cpq_t *q, void **item, u64 *key)
+{
+    if (q->n_shards == 1)
+	return pop_any(q, item, key);
+
+    /* a few rounds of two choices, the cached top keys are read without locking */
+    for (u32 round = 0; round < 4; round++) {
+	struct cpq_shard_t *a = &q->shards[random_shard(q)];
+	struct cpq_shard_t *b = &q->shards[random_shard(q)];
+	u64 key_a = atomic_load_explicit(&a->top_key, memory_order_relaxed);
+	u64 key_b = atomic_load_explicit(&b->top_key, memory_order_relaxed);
+	struct cpq_shard_t *best = key_b < key_a ? b : a;
+	if ((key_b < key_a ? key_b : key_a) == EMPTY_KEY)
+	    continue;
+
+	if (pthread_mutex_trylock(&best->lock) != 0)
+	    continue;
+	/* the shard may have been drained since its key was read */
+	if (best->heap.size > 0) {
+	    pop_locked(q, best, item, key);
+	    pthread_mutex_unlock(&best->lock);
+	    return true;
+	}
+	pthread_mutex_unlock(&best->lock);
+    }
+
+    /*
+     * both choices kept coming up empty or busy. look through every shard before
+     * reporting the cpq empty, this also finds items whose key is EMPTY_KEY
+     */
+    return pop_any(q, item, key);
+}
+
+size_t cpq_size(struct cpq_t *q)
+{
+    return atomic_load_explicit(&q->size, memory_order_relaxed);
+}
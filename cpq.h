@@ -0,0 +1,77 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef NICC_CPQ_H
+#define NICC_CPQ_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "common.h"
+#include "heapq.h"
+
+#ifdef NICC_TYPEDEF
+typedef struct cpq_t ConcurrentPQ;
+#endif /* NICC_TYPEDEF */
+
+#define CPQ_SHARDS_PER_THREAD 2 // the c in c * threads sub-heaps of a relaxed cpq
+
+enum cpq_mode_t {
+    CPQ_STRICT, // one locked heap, pop always returns the smallest key
+    CPQ_RELAXED, // MultiQueue, pop returns one of the smallest keys
+};
+
+struct cpq_shard_t {
+    _Alignas(64) pthread_mutex_t lock;
+    struct heapq_t heap; // keyed copy heapq of item pointers
+    _Atomic u64 top_key; // smallest key in heap, UINT64_MAX if empty. read without the lock
+};
+
+/*
+ * Thread safe priority queue of item pointers ordered by u64 keys, smallest first.
+ *
+ * A strict cpq is a single heapq behind a mutex. A relaxed cpq is a MultiQueue:
+ * items are spread over c * threads locked sub-heaps, push goes to a random
+ * sub-heap and pop takes the smaller top of two random sub-heaps. Threads rarely
+ * meet on the same lock, so throughput scales with the threads, at the price of
+ * pop returning an item close to, but not always exactly, the smallest one.
+ */
+struct cpq_t {
+    struct cpq_shard_t *shards;
+    u32 n_shards;
+    _Atomic size_t size;
+};
+
+/*
+ * A relaxed cpq gets CPQ_SHARDS_PER_THREAD sub-heaps for each of the n_threads
+ * threads that use it. n_threads is ignored in strict mode.
+ */
+void cpq_init(struct cpq_t *q, enum cpq_mode_t mode, u32 n_threads);
+void cpq_free(struct cpq_t *q);
+
+void cpq_push(struct cpq_t *q, void *item, u64 key);
+
+/*
+ * pops an item and stores it and its key in item and key, unless key is NULL.
+ * returns false if every sub-heap was found empty.
+ */
+bool cpq_pop(struct cpq_t *q, void **item, u64 *key);
+
+/* number of items in the cpq, only exact while no other thread modifies it */
+size_t cpq_size(struct cpq_t *q);
+
+#endif /* NICC_CPQ_H */
@@ -0,0 +1,135 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand, Callum Gran
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#define NICC_TYPEDEF
+#include "../arraylist_par.h"
+
+#define N 100000
+
+static void double_it(void *elem, void *ctx)
+{
+    (void)ctx;
+    *(i64 *)elem *= 2;
+}
+
+static void to_double(const void *in, void *out, void *ctx)
+{
+    (void)ctx;
+    *(double *)out = (double)*(const i64 *)in / 2.0;
+}
+
+static bool is_multiple(const void *elem, void *ctx)
+{
+    return *(const i64 *)elem % *(i64 *)ctx == 0;
+}
+
+static void sum(void *acc, const void *elem, void *ctx)
+{
+    (void)ctx;
+    *(i64 *)acc += *(const i64 *)elem;
+}
+
+static void sum_combine(void *acc, const void *other, void *ctx)
+{
+    (void)ctx;
+    *(i64 *)acc += *(const i64 *)other;
+}
+
+void test_parallel(ThreadPool *pool)
+{
+    ArrayList arr;
+    arraylist_init(&arr, sizeof(i64));
+    for (i64 i = 0; i < N; i++)
+	arraylist_append(&arr, &i);
+
+    arraylist_par_for_each(pool, &arr, double_it, NULL);
+    for (i64 i = 0; i < N; i++)
+	assert(*(i64 *)arraylist_get(&arr, i) == i * 2);
+
+    ArrayList mapped;
+    arraylist_init(&mapped, sizeof(double));
+    assert(arraylist_par_map(pool, &arr, &mapped, to_double, NULL));
+    assert(mapped.size == N);
+    for (i64 i = 0; i < N; i++)
+	assert(*(double *)arraylist_get(&mapped, i) == (double)i);
+
+    ArrayList filtered;
+    arraylist_init(&filtered, sizeof(i64));
+    i64 divisor = 6;
+    assert(arraylist_par_filter(pool, &arr, &filtered, is_multiple, &divisor));
+    assert(filtered.size == N / 3 + 1);
+    /* order is preserved */
+    for (size_t i = 0; i < filtered.size; i++)
+	assert(*(i64 *)arraylist_get(&filtered, i) == (i64)i * 6);
+
+    i64 total = 0;
+    arraylist_par_reduce(pool, &arr, &total, sizeof(total), sum, sum_combine, NULL);
+    assert(total == (i64)N * (N - 1));
+
+    arraylist_free(&filtered);
+    arraylist_free(&mapped);
+    arraylist_free(&arr);
+}
+
+void test_dst_no_room(ThreadPool *pool)
+{
+    const char *path = "nicc_arraylist_par_test.bin";
+    remove(path);
+
+    ArrayList arr;
+    arraylist_init(&arr, sizeof(i64));
+    for (i64 i = 0; i < N; i++)
+	arraylist_append(&arr, &i);
+
+    ArrayList dst;
+    assert(arraylist_open(&dst, path, sizeof(i64)));
+
+    /* a file size limit stops the file backed dst from growing */
+    struct rlimit old;
+    getrlimit(RLIMIT_FSIZE, &old);
+    signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &(struct rlimit){ .rlim_cur = 4096, .rlim_max = old.rlim_max });
+
+    i64 divisor = 1;
+    assert(!arraylist_par_filter(pool, &arr, &dst, is_multiple, &divisor));
+    assert(dst.size == 0);
+    assert(!arraylist_par_map(pool, &arr, &dst, to_double, NULL));
+    assert(dst.size == 0);
+
+    setrlimit(RLIMIT_FSIZE, &old);
+    signal(SIGXFSZ, SIG_DFL);
+    arraylist_free(&dst);
+    arraylist_free(&arr);
+    remove(path);
+}
+
+int main(void)
+{
+    ThreadPool pool;
+    threadpool_init(&pool, 3);
+    test_parallel(&pool);
+    test_dst_no_room(&pool);
+    threadpool_free(&pool);
+
+    /* without a pool everything runs on the calling thread */
+    test_parallel(NULL);
+}
@@ -15,6 +15,8 @@
  *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 
 #define NICC_TYPEDEF
@@ -298,6 +300,262 @@ void test_sort(void)
     arraylist_free(&arr);
 }
 
+void test_radix_sort(void)
+{
+    /* ArrayList will hold values of Tuple */
+    ArrayList arr;
+    arraylist_init(&arr, sizeof(Tuple));
+
+    int keys[] = { 300, -5, 7, 0, -70000, 7, 42, -1 };
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++)
+	arraylist_append(&arr, &(Tuple){ .a = keys[i], .b = -(double)i });
+
+    bool rc = arraylist_radix_sort_i(&arr, offsetof(Tuple, a), sizeof(int));
+    assert(rc);
+    for (size_t i = 1; i < arr.size; i++)
+	assert(((Tuple *)arraylist_get(&arr, i - 1))->a <= ((Tuple *)arraylist_get(&arr, i))->a);
+
+    /* stable: the two sevens keep their relative order */
+    Tuple *get = arraylist_get(&arr, 4);
+    assert(get->a == 7 && get->b == -2.0);
+    get = arraylist_get(&arr, 5);
+    assert(get->a == 7 && get->b == -5.0);
+
+    rc = arraylist_radix_sort_f(&arr, offsetof(Tuple, b), sizeof(double));
+    assert(rc);
+    for (size_t i = 1; i < arr.size; i++)
+	assert(((Tuple *)arraylist_get(&arr, i - 1))->b <= ((Tuple *)arraylist_get(&arr, i))->b);
+
+    /* key does not fit inside the element */
+    rc = arraylist_radix_sort_u(&arr, sizeof(Tuple) - 2, 4);
+    assert(!rc);
+
+    arraylist_free(&arr);
+}
+
+void test_typed_search(void)
+{
+    ArrayList arr;
+    arraylist_init(&arr, sizeof(u32));
+
+    for (u32 i = 0; i < 100; i++)
+	arraylist_append(&arr, &(u32){ i % 10 });
+
+    assert(arraylist_index_of_u32(&arr, 7) == 7);
+    assert(arraylist_index_of_u32(&arr, 10) == NICC_NOT_FOUND);
+    assert(arraylist_count_of_u32(&arr, 3) == 10);
+    /* bytewise search dispatches to the same kernel */
+    assert(arraylist_index_of(&arr, &(u32){ 9 }, NULL) == 9);
+
+    ArrayList indices;
+    arraylist_init(&indices, sizeof(size_t));
+    size_t found = arraylist_find_all_u32(&arr, 4, &indices);
+    assert(found == 10 && indices.size == 10);
+    for (size_t i = 0; i < indices.size; i++)
+	assert(*(size_t *)arraylist_get(&indices, i) == i * 10 + 4);
+
+    /* wrong element type */
+    assert(arraylist_index_of_u64(&arr, 7) == NICC_NOT_FOUND);
+
+    bool rc = arraylist_rmv(&arr, &(u32){ 0 }, NULL);
+    assert(rc);
+    assert(arraylist_count_of(&arr, &(u32){ 0 }, NULL) == 9);
+
+    arraylist_free(&indices);
+    arraylist_free(&arr);
+}
+
+NICC_ARRAYLIST_DEFINE(tuplelist, Tuple, 2)
+
+void test_typed_inline(void)
+{
+    struct tuplelist list;
+    tuplelist_init(&list);
+
+    tuplelist_append(&list, (Tuple){ .a = 1, .b = 1.1 });
+    tuplelist_append(&list, (Tuple){ .a = 2, .b = 2.2 });
+    /* still stored inline */
+    assert(list.cap == 2);
+    assert(tuplelist_get(&list, 1)->a == 2);
+
+    /* third element moves the list to the heap */
+    tuplelist_append(&list, (Tuple){ .a = 3, .b = 3.3 });
+    assert(list.cap == 4);
+    assert(tuplelist_get(&list, 0)->a == 1);
+    assert(tuplelist_get(&list, 2)->b == 3.3);
+    assert(tuplelist_get(&list, 3) == NULL);
+
+    bool rc = tuplelist_set(&list, (Tuple){ .a = 4, .b = 4.4 }, 0);
+    assert(rc);
+
+    Tuple pop;
+    rc = tuplelist_pop(&list, &pop);
+    assert(rc && pop.a == 3);
+    assert(tuplelist_get(&list, 0)->a == 4);
+
+    tuplelist_free(&list);
+}
+
+void test_mapped(void)
+{
+    const char *path = "nicc_arraylist_test.bin";
+    remove(path);
+
+    ArrayList arr;
+    bool rc = arraylist_open(&arr, path, sizeof(Tuple));
+    assert(rc);
+
+    /* grows the file a couple of times */
+    for (int i = 0; i < 100; i++)
+	arraylist_append(&arr, &(Tuple){ .a = i, .b = i * 0.5 });
+    arraylist_free(&arr);
+
+    rc = arraylist_open(&arr, path, sizeof(Tuple));
+    assert(rc);
+    assert(arr.size == 100);
+    Tuple *get = arraylist_get(&arr, 42);
+    assert(get->a == 42);
+    assert(get->b == 21.0);
+    arraylist_free(&arr);
+
+    /* element size must match what the file was written with */
+    rc = arraylist_open(&arr, path, sizeof(int));
+    assert(!rc);
+
+    /* a file that is not an arraylist is rejected without being modified */
+    FILE *f = fopen(path, "wb");
+    char foreign[100];
+    for (size_t i = 0; i < sizeof(foreign); i++)
+	foreign[i] = (char)i;
+    fwrite(foreign, 1, sizeof(foreign), f);
+    fclose(f);
+
+    rc = arraylist_open(&arr, path, sizeof(Tuple));
+    assert(!rc);
+    char contents[sizeof(foreign) + 1];
+    f = fopen(path, "rb");
+    assert(fread(contents, 1, sizeof(contents), f) == sizeof(foreign));
+    assert(memcmp(contents, foreign, sizeof(foreign)) == 0);
+    fclose(f);
+
+    remove(path);
+}
+
+void test_sorted_search(void)
+{
+    /* ArrayList will hold values of Tuple */
+    ArrayList arr;
+    arraylist_init(&arr, sizeof(Tuple));
+
+    int keys[] = { 5, 1, 3, 3, 9, 7, 3 };
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++)
+	arraylist_insert_sorted(&arr, &(Tuple){ .a = keys[i], .b = (double)i }, tuple_int_cmp);
+
+    for (size_t i = 1; i < arr.size; i++)
+	assert(((Tuple *)arraylist_get(&arr, i - 1))->a <= ((Tuple *)arraylist_get(&arr, i))->a);
+    /* equal elements keep their insertion order */
+    assert(((Tuple *)arraylist_get(&arr, 1))->b == 2.0);
+    assert(((Tuple *)arraylist_get(&arr, 3))->b == 6.0);
+
+    assert(arraylist_lower_bound(&arr, &(Tuple){ .a = 3 }, tuple_int_cmp) == 1);
+    assert(arraylist_upper_bound(&arr, &(Tuple){ .a = 3 }, tuple_int_cmp) == 4);
+    assert(arraylist_lower_bound(&arr, &(Tuple){ .a = 10 }, tuple_int_cmp) == arr.size);
+
+    struct arraylist_search_index_t index;
+    bool rc = arraylist_build_search_index(&arr, &index, offsetof(Tuple, a), sizeof(int));
+    assert(rc);
+    for (int key = 0; key <= 10; key++)
+	assert(arraylist_search_index_lower_bound(&index, (u64)key) ==
+	       arraylist_lower_bound(&arr, &(Tuple){ .a = key }, tuple_int_cmp));
+    arraylist_search_index_free(&index);
+    arraylist_free(&arr);
+
+    ArrayList ints;
+    arraylist_init(&ints, sizeof(i64));
+    for (i64 i = -50; i < 50; i += 2)
+	arraylist_append(&ints, &i);
+    assert(arraylist_lower_bound_i64(&ints, -50) == 0);
+    assert(arraylist_lower_bound_i64(&ints, -49) == 1);
+    assert(arraylist_upper_bound_i64(&ints, 0) == 26);
+    assert(arraylist_lower_bound_i64(&ints, 100) == ints.size);
+    arraylist_free(&ints);
+}
+
+static bool tuple_a_above(const void *elem, void *ctx)
+{
+    return ((const Tuple *)elem)->a > *(int *)ctx;
+}
+
+static bool tuple_a_equal(const void *a, const void *b)
+{
+    return ((const Tuple *)a)->a == ((const Tuple *)b)->a;
+}
+
+typedef struct {
+    size_t calls;
+    int keep_every; // keeps every n-th element it is called with
+} EveryNth;
+
+static bool keep_every_nth(const void *elem, void *ctx)
+{
+    (void)elem;
+    EveryNth *state = ctx;
+    return state->calls++ % state->keep_every == 0;
+}
+
+void test_compaction(void)
+{
+    /* ArrayList will hold values of Tuple */
+    ArrayList arr;
+    arraylist_init(&arr, sizeof(Tuple));
+
+    for (int i = 0; i < 10; i++)
+	arraylist_append(&arr, &(Tuple){ .a = i, .b = i * 1.5 });
+
+    bool rc = arraylist_swap_rm(&arr, 2);
+    assert(rc);
+    assert(arr.size == 9);
+    assert(((Tuple *)arraylist_get(&arr, 2))->a == 9);
+
+    int threshold = 4;
+    size_t removed = arraylist_retain(&arr, tuple_a_above, &threshold);
+    assert(removed == 4);
+    assert(arr.size == 5);
+    /* order of the kept elements is unchanged */
+    int expected[] = { 9, 5, 6, 7, 8 };
+    for (size_t i = 0; i < arr.size; i++)
+	assert(((Tuple *)arraylist_get(&arr, i))->a == expected[i]);
+
+    arraylist_free(&arr);
+
+    arraylist_init(&arr, sizeof(Tuple));
+    int dups[] = { 1, 1, 2, 3, 3, 3, 4 };
+    for (size_t i = 0; i < sizeof(dups) / sizeof(dups[0]); i++)
+	arraylist_append(&arr, &(Tuple){ .a = dups[i], .b = (double)i });
+
+    removed = arraylist_dedup_sorted(&arr, tuple_a_equal);
+    assert(removed == 3);
+    assert(arr.size == 4);
+    assert(((Tuple *)arraylist_get(&arr, 2))->a == 3);
+    assert(((Tuple *)arraylist_get(&arr, 2))->b == 3.0);
+
+    arraylist_free(&arr);
+
+    /* a stateful predicate sees every element exactly once */
+    arraylist_init(&arr, sizeof(Tuple));
+    for (int i = 0; i < 100; i++)
+	arraylist_append(&arr, &(Tuple){ .a = i, .b = 0.0 });
+
+    EveryNth state = { .calls = 0, .keep_every = 3 };
+    removed = arraylist_retain(&arr, keep_every_nth, &state);
+    assert(state.calls == 100);
+    assert(removed == 66);
+    for (size_t i = 0; i < arr.size; i++)
+	assert(((Tuple *)arraylist_get(&arr, i))->a == (int)i * 3);
+
+    arraylist_free(&arr);
+}
+
 int main(void)
 {
     test();
@@ -307,4 +565,10 @@ int main(void)
     test_pop();
     test_rm();
     test_sort();
+    test_radix_sort();
+    test_typed_search();
+    test_typed_inline();
+    test_mapped();
+    test_sorted_search();
+    test_compaction();
 }
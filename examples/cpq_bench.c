@@ -0,0 +1,97 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/*
+ * Contention benchmark of cpq_t. Every thread runs a scheduler loop of push +
+ * pop pairs against one shared queue, which is prefilled so pops rarely find
+ * it empty. Compares the strict single lock cpq with the relaxed MultiQueue.
+ * cc -O2 -pthread cpq_bench.c ../cpq.c ../heapq.c ../common.c
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../cpq.h"
+
+#define OPS_PER_THREAD 1000000
+#define PREFILL 100000
+
+struct bench_t {
+    struct cpq_t q;
+    pthread_barrier_t start;
+};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *worker(void *arg)
+{
+    struct bench_t *bench = arg;
+    u64 rng = (u64)(uintptr_t)&rng | 1;
+    pthread_barrier_wait(&bench->start);
+
+    for (size_t i = 0; i < OPS_PER_THREAD; i++) {
+	void *job;
+	u64 key;
+	if (!cpq_pop(&bench->q, &job, &key))
+	    key = 0;
+	/* reschedule the job somewhere in the future */
+	rng ^= rng << 13;
+	rng ^= rng >> 7;
+	rng ^= rng << 17;
+	cpq_push(&bench->q, job, key + (rng >> 44));
+    }
+    return NULL;
+}
+
+static double run(enum cpq_mode_t mode, u32 n_threads)
+{
+    struct bench_t bench;
+    cpq_init(&bench.q, mode, n_threads);
+    for (u64 i = 0; i < PREFILL; i++)
+	cpq_push(&bench.q, NULL, i * 16);
+    pthread_barrier_init(&bench.start, NULL, n_threads + 1);
+
+    pthread_t threads[64];
+    for (u32 i = 0; i < n_threads; i++)
+	pthread_create(&threads[i], NULL, worker, &bench);
+    pthread_barrier_wait(&bench.start);
+    double start = now();
+    for (u32 i = 0; i < n_threads; i++)
+	pthread_join(threads[i], NULL);
+    double elapsed = now() - start;
+
+    pthread_barrier_destroy(&bench.start);
+    cpq_free(&bench.q);
+    return 2.0 * OPS_PER_THREAD * n_threads / elapsed;
+}
+
+int main(void)
+{
+    u32 thread_counts[] = { 1, 2, 4, 8, 16 };
+
+    printf("%-10s %16s %16s   (Mops/s)\n", "threads", "strict", "relaxed");
+    for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); i++) {
+	u32 n = thread_counts[i];
+	printf("%-10u %16.2f %16.2f\n", n, run(CPQ_STRICT, n) / 1e6, run(CPQ_RELAXED, n) / 1e6);
+    }
+}
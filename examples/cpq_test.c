@@ -0,0 +1,130 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#define NICC_TYPEDEF
+#include "../cpq.h"
+
+#define THREADS 4
+#define PER_THREAD 20000
+
+typedef struct {
+    ConcurrentPQ *q;
+    u64 *jobs; // PER_THREAD jobs owned by this thread
+    _Atomic u32 *seen; // pop count of every job, shared by all threads
+} Worker;
+
+static void *worker(void *arg)
+{
+    Worker *w = arg;
+    for (int i = 0; i < PER_THREAD; i++) {
+	cpq_push(w->q, &w->jobs[i], w->jobs[i]);
+	/* pop about every other push, so the queue grows while it is shared */
+	void *item;
+	if (i % 2 && cpq_pop(w->q, &item, NULL))
+	    atomic_fetch_add(&w->seen[*(u64 *)item], 1);
+    }
+    return NULL;
+}
+
+void test_strict_order(void)
+{
+    ConcurrentPQ q;
+    cpq_init(&q, CPQ_STRICT, 1);
+
+    u64 keys[1000];
+    for (int i = 0; i < 1000; i++) {
+	keys[i] = (u64)(rand() % 500);
+	cpq_push(&q, &keys[i], keys[i]);
+    }
+    assert(cpq_size(&q) == 1000);
+
+    u64 last = 0;
+    void *item;
+    u64 key;
+    while (cpq_pop(&q, &item, &key)) {
+	assert(key >= last && *(u64 *)item == key);
+	last = key;
+    }
+    assert(cpq_size(&q) == 0);
+    cpq_free(&q);
+}
+
+void test_threads(enum cpq_mode_t mode)
+{
+    ConcurrentPQ q;
+    cpq_init(&q, mode, THREADS);
+
+    static u64 jobs[THREADS * PER_THREAD];
+    static _Atomic u32 seen[THREADS * PER_THREAD];
+    for (u64 i = 0; i < THREADS * PER_THREAD; i++) {
+	jobs[i] = i;
+	atomic_store(&seen[i], 0);
+    }
+
+    pthread_t threads[THREADS];
+    Worker workers[THREADS];
+    for (int t = 0; t < THREADS; t++) {
+	workers[t] = (Worker){ .q = &q, .jobs = &jobs[t * PER_THREAD], .seen = seen };
+	pthread_create(&threads[t], NULL, worker, &workers[t]);
+    }
+    for (int t = 0; t < THREADS; t++)
+	pthread_join(threads[t], NULL);
+
+    /* drain the rest, every job comes out exactly once */
+    void *item;
+    while (cpq_pop(&q, &item, NULL))
+	atomic_fetch_add(&seen[*(u64 *)item], 1);
+    for (u64 i = 0; i < THREADS * PER_THREAD; i++)
+	assert(atomic_load(&seen[i]) == 1);
+    assert(cpq_size(&q) == 0);
+    cpq_free(&q);
+}
+
+void test_relaxed_order(void)
+{
+    /* single threaded, a relaxed pop is still never far from the smallest key */
+    ConcurrentPQ q;
+    cpq_init(&q, CPQ_RELAXED, 4);
+
+    static u64 keys[10000];
+    for (u64 i = 0; i < 10000; i++) {
+	keys[i] = i;
+	cpq_push(&q, &keys[i], i);
+    }
+
+    u64 key;
+    void *item;
+    u64 popped = 0;
+    while (cpq_pop(&q, &item, &key)) {
+	assert(*(u64 *)item == key);
+	assert(key < popped + 1000);
+	popped++;
+    }
+    assert(popped == 10000);
+    cpq_free(&q);
+}
+
+int main(void)
+{
+    test_strict_order();
+    test_threads(CPQ_STRICT);
+    test_threads(CPQ_RELAXED);
+    test_relaxed_order();
+}
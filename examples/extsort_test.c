@@ -0,0 +1,145 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NICC_TYPEDEF
+#include "../extsort.h"
+
+typedef struct {
+    u64 key;
+    u64 id;
+} Record;
+
+typedef struct {
+    u64 last;
+    size_t count;
+    u64 id_sum;
+} Check;
+
+static i32 record_compare(const void *a, const void *b)
+{
+    u64 x = ((const Record *)a)->key;
+    u64 y = ((const Record *)b)->key;
+    return (x > y) - (x < y);
+}
+
+static void check_record(const void *record, void *ctx)
+{
+    const Record *r = record;
+    Check *c = ctx;
+    assert(r->key >= c->last);
+    c->last = r->key;
+    c->count++;
+    c->id_sum += r->id;
+}
+
+static void sort_records(size_t n, size_t memory_bytes, bool radix)
+{
+    ExtSort s;
+    assert(extsort_init(&s, sizeof(Record), record_compare, memory_bytes));
+    if (radix)
+	extsort_use_radix(&s, 0, sizeof(u64));
+
+    for (u64 i = 0; i < n; i++)
+	assert(extsort_push(&s, &(Record){ .key = (u64)rand() % 100000, .id = i }));
+    assert(s.size == n);
+    /* the run buffer never grew past memory_bytes */
+    assert(s.run.cap == s.run_capacity);
+
+    Check c = { 0 };
+    assert(extsort_finish(&s, check_record, &c));
+    /* every record came out exactly once */
+    assert(c.count == n);
+    assert(c.id_sum == (u64)n * (n - 1) / 2);
+    extsort_free(&s);
+}
+
+void test_extsort(void)
+{
+    /* runs of 1000 records spill 200 runs of several read blocks each */
+    sort_records(200000, 1000 * sizeof(Record), false);
+    sort_records(200000, 1000 * sizeof(Record), true);
+    /* everything fits in memory, nothing is spilled */
+    sort_records(5000, 1 << 20, false);
+    sort_records(0, 1 << 20, false);
+    /* a run of one record */
+    sort_records(100, 1, false);
+}
+
+void test_extsort_file(void)
+{
+    ExtSort s;
+    assert(extsort_init(&s, sizeof(Record), record_compare, 4096));
+    for (u64 i = 0; i < 50000; i++)
+	extsort_push(&s, &(Record){ .key = 50000 - i, .id = i });
+
+    FILE *out = tmpfile();
+    assert(out != NULL);
+    assert(extsort_finish_file(&s, out));
+    extsort_free(&s);
+
+    rewind(out);
+    Record r;
+    u64 expected = 1;
+    while (fread(&r, sizeof(Record), 1, out) == 1) {
+	assert(r.key == expected && r.id == 50000 - expected);
+	expected++;
+    }
+    assert(expected == 50001);
+    fclose(out);
+}
+
+void test_kway_merge(void)
+{
+    ArrayList lists[5];
+    for (u32 i = 0; i < 5; i++) {
+	arraylist_init(&lists[i], sizeof(Record));
+	u64 key = 0;
+	/* list 4 is left empty */
+	for (u64 j = 0; i < 4 && j < 1000 * (i + 1); j++) {
+	    key += (u64)rand() % 10;
+	    arraylist_append(&lists[i], &(Record){ .key = key, .id = i });
+	}
+    }
+
+    ArrayList out;
+    arraylist_init(&out, sizeof(Record));
+    assert(nicc_kway_merge(lists, 5, record_compare, &out));
+    assert(out.size == 1000 + 2000 + 3000 + 4000);
+
+    size_t per_list[5] = { 0 };
+    for (size_t i = 0; i < out.size; i++) {
+	Record *r = arraylist_get(&out, i);
+	if (i > 0)
+	    assert(((Record *)arraylist_get(&out, i - 1))->key <= r->key);
+	per_list[r->id]++;
+    }
+    for (u32 i = 0; i < 5; i++) {
+	assert(per_list[i] == lists[i].size);
+	arraylist_free(&lists[i]);
+    }
+    arraylist_free(&out);
+}
+
+int main(void)
+{
+    test_extsort();
+    test_extsort_file();
+    test_kway_merge();
+}
@@ -0,0 +1,113 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/*
+ * Push/pop throughput of heapq_t for every arity and a range of heap sizes.
+ * The heap is filled to size and then driven with pop + push pairs, the way a
+ * timer queue is used.
+ * cc -O2 heapq_bench.c ../heapq.c ../common.c
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../heapq.h"
+
+#define OPS 2000000
+
+typedef struct {
+    u64 deadline;
+    u64 id;
+} Timer;
+
+static i32 timer_compare(const void *a, const void *b)
+{
+    u64 x = ((const Timer *)a)->deadline;
+    u64 y = ((const Timer *)b)->deadline;
+    return (x > y) - (x < y);
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static u64 rng = 88172645463325252ull;
+
+static u64 next_random(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng;
+}
+
+/* ops per second of pop + push pairs on a heapq holding size timers */
+static double run(u32 arity, size_t size, bool keyed)
+{
+    struct heapq_t hq;
+    heapq_init_copy(&hq, sizeof(Timer), keyed ? NULL : timer_compare);
+    heapq_set_arity(&hq, arity);
+
+    Timer t = { 0 };
+    for (size_t i = 0; i < size; i++) {
+	t.deadline = next_random() >> 16;
+	t.id = i;
+	if (keyed)
+	    heapq_push_copy_key(&hq, &t, t.deadline);
+	else
+	    heapq_push_copy(&hq, &t);
+    }
+
+    double start = now();
+    for (size_t i = 0; i < OPS; i++) {
+	heapq_pop_copy(&hq, &t);
+	/* rearm the timer a random amount into the future */
+	t.deadline += next_random() >> 40;
+	if (keyed)
+	    heapq_push_copy_key(&hq, &t, t.deadline);
+	else
+	    heapq_push_copy(&hq, &t);
+    }
+    double elapsed = now() - start;
+
+    heapq_free(&hq);
+    return 2 * OPS / elapsed;
+}
+
+int main(void)
+{
+    size_t sizes[] = { 1000, 100000, 1000000, 4000000 };
+    u32 arities[] = { 2, 4, 8 };
+
+    for (int keyed = 0; keyed < 2; keyed++) {
+	printf("%s\n", keyed ? "keyed (u64 key, no cmp)" : "cmp");
+	printf("%-10s", "size");
+	for (size_t a = 0; a < sizeof(arities) / sizeof(arities[0]); a++)
+	    printf(" %10u-ary", arities[a]);
+	printf("   (Mops/s)\n");
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+	    printf("%-10zu", sizes[s]);
+	    for (size_t a = 0; a < sizeof(arities) / sizeof(arities[0]); a++)
+		printf(" %14.2f", run(arities[a], sizes[s], keyed) / 1e6);
+	    printf("\n");
+	}
+    }
+}
@@ -77,9 +77,279 @@ void test_heapq_sort(void)
     assert(strncmp(arr[3].name, b.name, strlen(b.name)) == 0);
 }
 
+void test_heapq_copy(void)
+{
+    struct heapq_t queue;
+    heapq_init_copy(&queue, sizeof(Tuple), tuple_compare);
+
+    /* pushed by value, the locals may go out of scope */
+    for (int i = 100; i > 0; i--) {
+	Tuple t = { .name = "t", .precedence = (i * 37) % 101 };
+	heapq_push_copy(&queue, &t);
+    }
+    assert(queue.size == 100);
+
+    Tuple t;
+    int last = -1;
+    while (heapq_pop_copy(&queue, &t)) {
+	assert(t.precedence > last);
+	last = t.precedence;
+    }
+    assert(queue.size == 0);
+
+    /* the pointer functions refuse a copy heapq instead of touching items */
+    assert(!heapq_push(&queue, &t));
+    assert(heapq_pop(&queue) == NULL);
+    assert(heapq_pushpop(&queue, &t) == NULL);
+    assert(heapq_replace(&queue, &t) == NULL);
+    assert(queue.size == 0);
+    heapq_free(&queue);
+}
+
+void test_heapq_keyed(void)
+{
+    struct heapq_t queue;
+    heapq_init_copy(&queue, sizeof(int), NULL);
+
+    for (int i = 0; i < 1000; i++) {
+	int deadline = rand() % 500;
+	heapq_push_copy_key(&queue, &deadline, (u64)deadline);
+    }
+
+    int deadline;
+    u64 last = 0;
+    while (queue.size > 0) {
+	u64 key = heapq_top_key(&queue);
+	assert(key >= last);
+	heapq_pop_copy(&queue, &deadline);
+	assert((u64)deadline == key);
+	last = key;
+    }
+    heapq_free(&queue);
+}
+
+static inline i32 int_compare(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+void test_heapq_index_macros(void)
+{
+    /* the binary heap macros are kept next to the d-ary helpers */
+    for (int i = 0; i < 100; i++) {
+	assert(heapq_left_child_idx(i) == (int)heapq_dary_first_child_idx(i, 1));
+	assert(heapq_right_child_idx(i) == heapq_left_child_idx(i) + 1);
+	assert(heapq_parent_idx(heapq_left_child_idx(i)) == i);
+	assert(heapq_parent_idx(heapq_right_child_idx(i)) == i);
+	assert(heapq_dary_parent_idx((int)heapq_dary_first_child_idx(i, 2) + 3, 2) == i);
+    }
+    assert(heapq_has_left(0, 2) && !heapq_has_right(0, 2));
+}
+
+void test_heapq_arity(void)
+{
+    static int values[2000];
+    for (int i = 0; i < 2000; i++)
+	values[i] = rand() % 1000;
+
+    for (u32 arity = 2; arity <= HEAPQ_MAX_ARITY; arity *= 2) {
+	struct heapq_t queue;
+	heapq_init(&queue, int_compare);
+	assert(heapq_set_arity(&queue, arity));
+	for (int i = 0; i < 2000; i++)
+	    heapq_push(&queue, &values[i]);
+	assert(!heapq_set_arity(&queue, 2));
+
+	int last = -1;
+	for (int i = 0; i < 2000; i++) {
+	    int *v = heapq_pop(&queue);
+	    assert(*v >= last);
+	    last = *v;
+	}
+	assert(heapq_pop(&queue) == NULL);
+	heapq_free(&queue);
+    }
+
+    struct heapq_t queue;
+    heapq_init_copy(&queue, sizeof(int), NULL);
+    assert(!heapq_set_arity(&queue, 3));
+    assert(!heapq_set_arity(&queue, 32));
+    heapq_free(&queue);
+}
+
+static inline i32 int_compare_desc(const void *a, const void *b)
+{
+    return *(const int *)b - *(const int *)a;
+}
+
+void test_heapq_from_array(void)
+{
+    int values[1000];
+    int *ptrs[1000];
+    for (int i = 0; i < 1000; i++) {
+	values[i] = rand() % 1000;
+	ptrs[i] = &values[i];
+    }
+
+    struct heapq_t queue;
+    heapq_init(&queue, int_compare);
+    heapq_push(&queue, &values[0]);
+    heapq_from_array(&queue, ptrs, 1000);
+    assert(queue.size == 1001);
+    int last = -1;
+    while (queue.size > 0) {
+	int *v = heapq_pop(&queue);
+	assert(*v >= last);
+	last = *v;
+    }
+    heapq_free(&queue);
+
+    /* copy heapq, and the same values as keys */
+    u64 keys[1000];
+    for (int i = 0; i < 1000; i++)
+	keys[i] = (u64)values[i];
+    heapq_init_copy(&queue, sizeof(int), NULL);
+    heapq_from_array_key(&queue, values, keys, 1000);
+    last = -1;
+    int v;
+    while (heapq_pop_copy(&queue, &v)) {
+	assert(v >= last);
+	last = v;
+    }
+    heapq_free(&queue);
+}
+
+void test_heapq_pushpop_replace(void)
+{
+    int a = 1, b = 2, c = 3;
+    struct heapq_t queue;
+    heapq_init(&queue, int_compare);
+    assert(heapq_pushpop(&queue, &a) == &a);
+    assert(heapq_replace(&queue, &b) == NULL);
+    /* smaller than the top, comes straight back */
+    assert(heapq_pushpop(&queue, &a) == &a);
+    assert(heapq_pushpop(&queue, &c) == &b);
+    assert(heapq_replace(&queue, &a) == &c);
+    assert(queue.size == 1 && heapq_get(&queue, 0) == &a);
+    heapq_free(&queue);
+
+    heapq_init_copy(&queue, sizeof(int), int_compare);
+    int out = 0;
+    assert(!heapq_replace_copy(&queue, &b, &out));
+    assert(out == 0);
+    heapq_pushpop_copy(&queue, &a, &out);
+    assert(out == 1);
+    heapq_pushpop_copy(&queue, &c, &out);
+    assert(out == 2 && *(int *)heapq_get(&queue, 0) == 3);
+    assert(heapq_replace_copy(&queue, &a, &out) && out == 3);
+    /* the popped item may be discarded */
+    heapq_pushpop_copy(&queue, &c, NULL);
+    assert(*(int *)heapq_get(&queue, 0) == 3);
+    heapq_pushpop_copy(&queue, &a, NULL);
+    assert(queue.size == 1 && *(int *)heapq_get(&queue, 0) == 3);
+    heapq_free(&queue);
+
+    heapq_init_copy(&queue, sizeof(int), NULL);
+    heapq_push_copy_key(&queue, &b, 20);
+    heapq_pushpop_copy_key(&queue, &c, 30, &out);
+    assert(out == 2 && heapq_top_key(&queue) == 30);
+    assert(heapq_replace_copy_key(&queue, &a, 10, &out) && out == 3);
+    assert(heapq_top_key(&queue) == 10);
+    heapq_free(&queue);
+}
+
+void test_heap_nsmallest_nlargest(void)
+{
+    int values[500];
+    int sorted[500];
+    for (int i = 0; i < 500; i++)
+	values[i] = sorted[i] = rand() % 10000;
+    qsort(sorted, 500, sizeof(int), int_compare);
+
+    int out[500];
+    assert(heap_nsmallest(values, 500, sizeof(int), 10, int_compare, out) == 10);
+    for (int i = 0; i < 10; i++)
+	assert(out[i] == sorted[i]);
+
+    assert(heap_nlargest(values, 500, sizeof(int), 10, int_compare, out) == 10);
+    for (int i = 0; i < 10; i++)
+	assert(out[i] == sorted[499 - i]);
+
+    /* asking for more than there is sorts everything */
+    assert(heap_nsmallest(values, 500, sizeof(int), 1000, int_compare_desc, out) == 500);
+    for (int i = 0; i < 500; i++)
+	assert(out[i] == sorted[499 - i]);
+    assert(heap_nlargest(values, 0, sizeof(int), 10, int_compare, out) == 0);
+}
+
+void test_heapq_indexed(void)
+{
+    struct heapq_indexed_t queue;
+    heapq_indexed_init(&queue);
+
+    /* shadow copy of every live key, indexed by handle */
+    static u64 keys[4096];
+    static bool live[4096];
+    static int items[4096];
+    for (int op = 0; op < 50000; op++) {
+	int r = rand() % 10;
+	u32 h = queue.size > 0 ? (u32)(rand() % (int)queue.n_handles) : HEAPQ_NO_HANDLE;
+	bool has = h != HEAPQ_NO_HANDLE && live[h];
+	assert(!has || heapq_indexed_contains(&queue, h));
+
+	if (r < 4 || queue.size == 0) {
+	    u64 key = (u64)(rand() % 1000);
+	    u32 handle = heapq_indexed_push(&queue, &items[0], key);
+	    assert(handle < 4096 && !live[handle]);
+	    items[handle] = (int)handle;
+	    keys[handle] = key;
+	    live[handle] = true;
+	} else if (r < 6 && has) {
+	    keys[h] /= 2;
+	    heapq_indexed_decrease_key(&queue, h, keys[h]);
+	} else if (r < 7 && has) {
+	    keys[h] += (u64)(rand() % 500);
+	    heapq_indexed_increase_key(&queue, h, keys[h]);
+	} else if (r < 8 && has) {
+	    heapq_indexed_remove(&queue, h);
+	    live[h] = false;
+	    assert(!heapq_indexed_contains(&queue, h));
+	} else {
+	    u64 min = UINT64_MAX;
+	    for (u32 i = 0; i < queue.n_handles; i++) {
+		if (live[i] && keys[i] < min)
+		    min = keys[i];
+	    }
+	    u32 top = heapq_indexed_top(&queue);
+	    assert(heapq_indexed_key(&queue, top) == min);
+	    u64 key;
+	    heapq_indexed_pop(&queue, &key);
+	    assert(key == min);
+	    live[top] = false;
+	}
+    }
+
+    u64 last = 0;
+    u64 key;
+    while (heapq_indexed_pop(&queue, &key) != NULL) {
+	assert(key >= last);
+	last = key;
+    }
+    assert(heapq_indexed_top(&queue) == HEAPQ_NO_HANDLE);
+    heapq_indexed_free(&queue);
+}
+
 int main(void)
 {
     test_heapq_push_pop();
+    test_heapq_index_macros();
     test_heapq_sort();
+    test_heapq_copy();
+    test_heapq_keyed();
+    test_heapq_arity();
+    test_heapq_from_array();
+    test_heapq_pushpop_replace();
+    test_heap_nsmallest_nlargest();
+    test_heapq_indexed();
     return 0;
 }
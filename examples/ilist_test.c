@@ -0,0 +1,106 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+
+#define NICC_TYPEDEF
+#include "../ilist.h"
+
+/* lives in two lists at once */
+typedef struct {
+    int id;
+    IListNode all;
+    IListNode lru;
+} Conn;
+
+static int id_at(IList *list, int pos)
+{
+    IListNode *node;
+    NICC_ILIST_FOR_EACH(list, node) {
+	if (pos-- == 0)
+	    return NICC_CONTAINER_OF(node, Conn, lru)->id;
+    }
+    return -1;
+}
+
+void test_two_lists(void)
+{
+    IList all;
+    IList lru;
+    ilist_init(&all);
+    ilist_init(&lru);
+
+    Conn conns[4];
+    for (int i = 0; i < 4; i++) {
+	conns[i].id = i;
+	ilist_push_back(&all, &conns[i].all);
+	ilist_push_back(&lru, &conns[i].lru);
+    }
+
+    ilist_move_to_front(&lru, &conns[2].lru);
+    assert(id_at(&lru, 0) == 2);
+    assert(id_at(&lru, 1) == 0);
+    assert(id_at(&lru, 3) == 3);
+
+    /* unlinking from one list leaves the other alone */
+    ilist_unlink(&conns[0].lru);
+    assert(!ilist_node_linked(&conns[0].lru));
+    assert(ilist_node_linked(&conns[0].all));
+    assert(NICC_CONTAINER_OF(ilist_first(&all), Conn, all)->id == 0);
+
+    ilist_insert_before(&conns[3].lru, &conns[0].lru);
+    assert(id_at(&lru, 2) == 0);
+
+    int count = 0;
+    IListNode *node;
+    IListNode *tmp;
+    NICC_ILIST_FOR_EACH_SAFE(&all, node, tmp) {
+	ilist_unlink(node);
+	count++;
+    }
+    assert(count == 4);
+    assert(ilist_empty(&all));
+}
+
+void test_splice(void)
+{
+    IList a;
+    IList b;
+    ilist_init(&a);
+    ilist_init(&b);
+
+    Conn conns[4];
+    for (int i = 0; i < 4; i++) {
+	conns[i].id = i;
+	ilist_push_back(i < 2 ? &a : &b, &conns[i].lru);
+    }
+
+    ilist_splice_back(&a, &b);
+    assert(ilist_empty(&b));
+    for (int i = 0; i < 4; i++)
+	assert(id_at(&a, i) == i);
+    assert(NICC_CONTAINER_OF(ilist_last(&a), Conn, lru)->id == 3);
+
+    IListNode *first = ilist_pop_front(&a);
+    assert(NICC_CONTAINER_OF(first, Conn, lru)->id == 0);
+    assert(ilist_pop_front(&b) == NULL);
+}
+
+int main(void)
+{
+    test_two_lists();
+    test_splice();
+}
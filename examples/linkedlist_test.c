@@ -76,9 +76,139 @@ void remove_test(void)
     linkedlist_free(&ll);
 }
 
+void shared_pool_test(void)
+{
+    struct slab_t pool;
+    linkedlist_pool_init(&pool);
+
+    LinkedList a;
+    LinkedList b;
+    linkedlist_init_shared(&a, (u32)sizeof(Tuple), &pool);
+    linkedlist_init_shared(&b, (u32)sizeof(Tuple), &pool);
+
+    Tuple t = { .a = 1, .b = 1.1 };
+    for (int i = 0; i < 100; i++) {
+        linkedlist_append(&a, &t);
+        linkedlist_append(&b, &t);
+    }
+    assert(a.size == 100 && b.size == 100);
+
+    /* items of a go back to the pool and are reused by b */
+    LinkedListItem *last = a.tail;
+    linkedlist_free(&a);
+    linkedlist_append(&b, &t);
+    assert(b.tail == last);
+
+    linkedlist_free(&b);
+    slab_free(&pool);
+}
+
+static i32 tuple_cmp(const void *a, const void *b)
+{
+    return ((const Tuple *)a)->a - ((const Tuple *)b)->a;
+}
+
+static void assert_sorted(LinkedList *ll, size_t size)
+{
+    assert(ll->size == size);
+    size_t n = 0;
+    LinkedListItem *item;
+    NICC_LL_FOR_EACH(ll, item) {
+        if (item->next != NULL) {
+            Tuple *t = item->data;
+            Tuple *next = item->next->data;
+            /* equal keys keep their insertion order, recorded in b */
+            assert(t->a < next->a || (t->a == next->a && t->b < next->b));
+            assert(item->next->prev == item);
+        }
+        n++;
+    }
+    assert(n == size);
+    assert(ll->head->prev == NULL && ll->tail->next == NULL);
+}
+
+void sort_test(void)
+{
+    LinkedList ll;
+    linkedlist_init(&ll, (u32)sizeof(Tuple));
+
+    Tuple tuples[1000];
+    for (int i = 0; i < 1000; i++) {
+        tuples[i] = (Tuple){ .a = rand() % 100, .b = i };
+        linkedlist_append(&ll, &tuples[i]);
+    }
+    LinkedListItem *first_item = ll.head;
+
+    linkedlist_sort(&ll, tuple_cmp);
+    assert_sorted(&ll, 1000);
+
+    /* items are relinked, not reallocated */
+    bool found = false;
+    LinkedListItem *item;
+    NICC_LL_FOR_EACH(&ll, item) {
+        found |= item == first_item;
+    }
+    assert(found);
+
+    linkedlist_free(&ll);
+}
+
+void splice_merge_test(void)
+{
+    struct slab_t pool;
+    linkedlist_pool_init(&pool);
+
+    LinkedList a;
+    LinkedList b;
+    LinkedList shared;
+    linkedlist_init(&a, (u32)sizeof(Tuple));
+    linkedlist_init(&b, (u32)sizeof(Tuple));
+    linkedlist_init_shared(&shared, (u32)sizeof(Tuple), &pool);
+
+    Tuple tuples[300];
+    for (int i = 0; i < 300; i++)
+        tuples[i] = (Tuple){ .a = i, .b = i };
+    for (int i = 0; i < 100; i += 2)
+        linkedlist_append(&a, &tuples[i]);
+    for (int i = 1; i < 100; i += 2)
+        linkedlist_append(&b, &tuples[i]);
+    for (int i = 100; i < 200; i++)
+        linkedlist_append(&shared, &tuples[i]);
+
+    /* own pool into own pool, the chunks of b now belong to a */
+    linkedlist_merge_sorted(&a, &b, tuple_cmp);
+    assert(b.size == 0 && b.head == NULL);
+    assert_sorted(&a, 100);
+
+    /* items of a foreign shared pool are copied over */
+    linkedlist_splice(&a, NULL, &shared);
+    assert(shared.size == 0);
+    assert_sorted(&a, 200);
+
+    /* splice in front and in the middle */
+    for (int i = 200; i < 300; i++)
+        linkedlist_append(&b, &tuples[i]);
+    linkedlist_splice(&a, a.head, &b);
+    assert(((Tuple *)a.head->data)->a == 200 && ((Tuple *)a.tail->data)->a == 199);
+    linkedlist_sort(&a, tuple_cmp);
+    assert_sorted(&a, 300);
+
+    linkedlist_append(&b, &tuples[0]);
+    linkedlist_splice(&a, a.head->next, &b);
+    assert(a.head->next->data == &tuples[0] && a.head->next->next->data == &tuples[1]);
+
+    linkedlist_free(&a);
+    linkedlist_free(&b);
+    linkedlist_free(&shared);
+    slab_free(&pool);
+}
+
 int main(void)
 {
     remove_test();
     remove_but_empty_test();
     remove_but_empty_test();
+    shared_pool_test();
+    sort_test();
+    splice_merge_test();
 }
@@ -0,0 +1,147 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/*
+ * Throughput of many producers funneling into one consumer, mpsc_queue_t versus
+ * a linkedlist_t guarded by a mutex.
+ * cc -O2 -pthread mpsc_bench.c ../mpsc.c ../linkedlist.c ../slab.c ../common.c
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../linkedlist.h"
+#include "../mpsc.h"
+
+#define PER_PRODUCER 1000000
+
+typedef struct {
+    u64 value;
+    struct mpsc_node_t node;
+} Event;
+
+struct bench_t {
+    struct mpsc_queue_t q;
+    struct linkedlist_t ll;
+    pthread_mutex_t lock;
+    Event *events;
+};
+
+struct producer_arg_t {
+    struct bench_t *bench;
+    int id;
+};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *mpsc_producer(void *arg)
+{
+    struct producer_arg_t *p = arg;
+    Event *events = p->bench->events + (size_t)p->id * PER_PRODUCER;
+    for (size_t i = 0; i < PER_PRODUCER; i++)
+	mpsc_push(&p->bench->q, &events[i].node);
+    return NULL;
+}
+
+static void *locked_producer(void *arg)
+{
+    struct producer_arg_t *p = arg;
+    Event *events = p->bench->events + (size_t)p->id * PER_PRODUCER;
+    for (size_t i = 0; i < PER_PRODUCER; i++) {
+	pthread_mutex_lock(&p->bench->lock);
+	linkedlist_append(&p->bench->ll, &events[i]);
+	pthread_mutex_unlock(&p->bench->lock);
+    }
+    return NULL;
+}
+
+static void sum_event(struct mpsc_node_t *node, void *ctx)
+{
+    *(u64 *)ctx += NICC_CONTAINER_OF(node, Event, node)->value;
+}
+
+static double run(struct bench_t *bench, int producers, bool use_mpsc)
+{
+    pthread_t threads[64];
+    struct producer_arg_t args[64];
+    size_t total = (size_t)producers * PER_PRODUCER;
+
+    double start = now();
+    for (int i = 0; i < producers; i++) {
+	args[i].bench = bench;
+	args[i].id = i;
+	pthread_create(&threads[i], NULL, use_mpsc ? mpsc_producer : locked_producer, &args[i]);
+    }
+
+    u64 sum = 0;
+    size_t consumed = 0;
+    while (consumed < total) {
+	if (use_mpsc) {
+	    consumed += mpsc_drain(&bench->q, sum_event, &sum, 0);
+	    continue;
+	}
+
+	pthread_mutex_lock(&bench->lock);
+	while (bench->ll.head != NULL) {
+	    sum += ((Event *)bench->ll.head->data)->value;
+	    linkedlist_remove_item(&bench->ll, bench->ll.head);
+	    consumed++;
+	}
+	pthread_mutex_unlock(&bench->lock);
+    }
+
+    for (int i = 0; i < producers; i++)
+	pthread_join(threads[i], NULL);
+    double elapsed = now() - start;
+
+    assert(sum == total * (total - 1) / 2);
+    return total / elapsed;
+}
+
+int main(void)
+{
+    int producer_counts[] = { 1, 2, 4, 8 };
+    struct bench_t bench;
+    bench.events = malloc(8 * (size_t)PER_PRODUCER * sizeof(Event));
+    for (size_t i = 0; i < 8 * (size_t)PER_PRODUCER; i++)
+	bench.events[i].value = i;
+
+    printf("%-10s %16s %16s\n", "producers", "mpsc ops/s", "mutex+ll ops/s");
+    for (size_t i = 0; i < sizeof(producer_counts) / sizeof(producer_counts[0]); i++) {
+	int producers = producer_counts[i];
+
+	mpsc_init(&bench.q);
+	double mpsc = run(&bench, producers, true);
+
+	linkedlist_init(&bench.ll, sizeof(Event));
+	pthread_mutex_init(&bench.lock, NULL);
+	double locked = run(&bench, producers, false);
+	pthread_mutex_destroy(&bench.lock);
+	linkedlist_free(&bench.ll);
+
+	printf("%-10d %16.0f %16.0f\n", producers, mpsc, locked);
+    }
+
+    free(bench.events);
+}
@@ -0,0 +1,109 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#define NICC_TYPEDEF
+#include "../mpsc.h"
+
+#define PRODUCERS 4
+#define PER_PRODUCER 100000
+
+typedef struct {
+    int producer;
+    int seq;
+    MPSCNode node;
+} Event;
+
+typedef struct {
+    MPSCQueue *q;
+    Event *events;
+} ProducerArg;
+
+static void *producer(void *arg)
+{
+    ProducerArg *p = arg;
+    for (int i = 0; i < PER_PRODUCER; i++)
+	mpsc_push(p->q, &p->events[i].node);
+    return NULL;
+}
+
+static void check_order(MPSCNode *node, void *ctx)
+{
+    int *last_seq = ctx;
+    Event *e = NICC_CONTAINER_OF(node, Event, node);
+    /* every producer's events arrive in the order they were pushed */
+    assert(e->seq == last_seq[e->producer] + 1);
+    last_seq[e->producer] = e->seq;
+}
+
+void test_single_thread(void)
+{
+    MPSCQueue q;
+    mpsc_init(&q);
+    assert(mpsc_pop(&q) == NULL);
+
+    Event a = { .seq = 1 };
+    Event b = { .seq = 2 };
+    mpsc_push(&q, &a.node);
+    mpsc_push(&q, &b.node);
+
+    assert(NICC_CONTAINER_OF(mpsc_pop(&q), Event, node)->seq == 1);
+    assert(NICC_CONTAINER_OF(mpsc_pop(&q), Event, node)->seq == 2);
+    assert(mpsc_pop(&q) == NULL);
+
+    /* the queue is usable again after running dry */
+    mpsc_push(&q, &a.node);
+    assert(mpsc_pop(&q) == &a.node);
+}
+
+void test_producers(void)
+{
+    MPSCQueue q;
+    mpsc_init(&q);
+
+    pthread_t threads[PRODUCERS];
+    ProducerArg args[PRODUCERS];
+    for (int p = 0; p < PRODUCERS; p++) {
+	args[p].q = &q;
+	args[p].events = malloc(PER_PRODUCER * sizeof(Event));
+	for (int i = 0; i < PER_PRODUCER; i++) {
+	    args[p].events[i].producer = p;
+	    args[p].events[i].seq = i;
+	}
+	pthread_create(&threads[p], NULL, producer, &args[p]);
+    }
+
+    int last_seq[PRODUCERS] = { -1, -1, -1, -1 };
+    size_t total = 0;
+    while (total < PRODUCERS * PER_PRODUCER)
+	total += mpsc_drain(&q, check_order, last_seq, 256);
+
+    for (int p = 0; p < PRODUCERS; p++) {
+	pthread_join(threads[p], NULL);
+	assert(last_seq[p] == PER_PRODUCER - 1);
+	free(args[p].events);
+    }
+    assert(mpsc_pop(&q) == NULL);
+}
+
+int main(void)
+{
+    test_single_thread();
+    test_producers();
+}
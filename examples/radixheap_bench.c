@@ -0,0 +1,106 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/*
+ * Discrete event simulation: pop the next event and schedule one or two
+ * follow-up events a random delay later, so popped keys never decrease. Compares
+ * radixheap_t against a keyed copy heapq_t of item pointers.
+ * cc -O2 radixheap_bench.c ../radixheap.c ../heapq.c ../common.c
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../heapq.h"
+#include "../radixheap.h"
+
+#define PENDING 1000000 // events in the queue while the simulation runs
+#define EVENTS 20000000
+#define MAX_DELAY 100000
+#define RNG_SEED 88172645463325252ull
+
+static u64 rng;
+
+static u64 random_delay(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (rng >> 32) % MAX_DELAY + 1;
+}
+
+static double elapsed(struct timespec *start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (double)(end.tv_sec - start->tv_sec) + (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static u64 bench_radixheap(void)
+{
+    struct radixheap_t h;
+    radixheap_init(&h);
+    rng = RNG_SEED;
+    for (u64 i = 0; i < PENDING; i++)
+	radixheap_push(&h, (void *)i, random_delay());
+
+    u64 sum = 0;
+    for (u64 i = 0; i < EVENTS; i++) {
+	u64 now;
+	void *item = radixheap_pop(&h, &now);
+	sum += now;
+	radixheap_push(&h, item, now + random_delay());
+    }
+    radixheap_free(&h);
+    return sum;
+}
+
+static u64 bench_heapq(void)
+{
+    struct heapq_t hq;
+    heapq_init_copy(&hq, sizeof(void *), NULL);
+    rng = RNG_SEED;
+    for (u64 i = 0; i < PENDING; i++)
+	heapq_push_copy_key(&hq, &(void *){ (void *)i }, random_delay());
+
+    u64 sum = 0;
+    for (u64 i = 0; i < EVENTS; i++) {
+	u64 now = heapq_top_key(&hq);
+	void *item;
+	heapq_pop_copy(&hq, &item);
+	sum += now;
+	heapq_push_copy_key(&hq, &item, now + random_delay());
+    }
+    heapq_free(&hq);
+    return sum;
+}
+
+int main(void)
+{
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    u64 a = bench_radixheap();
+    printf("radixheap_t:        %.3fs\n", elapsed(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    u64 b = bench_heapq();
+    printf("heapq_t (keyed):    %.3fs\n", elapsed(&start));
+
+    /* items with equal keys may pop in a different order, but the keys must match */
+    return a == b ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <stdlib.h>
+
+#define NICC_TYPEDEF
+#include "../radixheap.h"
+
+void test_order(void)
+{
+    RadixHeap h;
+    radixheap_init(&h);
+    assert(radixheap_pop(&h, NULL) == NULL);
+    assert(radixheap_top_key(&h) == UINT64_MAX);
+
+    u64 keys[1000];
+    for (int i = 0; i < 1000; i++) {
+	keys[i] = (u64)rand() * rand();
+	radixheap_push(&h, &keys[i], keys[i]);
+    }
+    assert(radixheap_size(&h) == 1000);
+
+    u64 last = 0;
+    u64 key;
+    u64 *item;
+    while ((item = radixheap_pop(&h, &key)) != NULL) {
+	assert(key >= last && *item == key);
+	last = key;
+    }
+    assert(radixheap_size(&h) == 0);
+    radixheap_free(&h);
+}
+
+void test_monotone(void)
+{
+    /* interleaved like a simulation: every pushed key is at least the last popped */
+    RadixHeap h;
+    radixheap_init(&h);
+    static u64 keys[20000];
+    int pushed = 0;
+    for (int i = 0; i < 100; i++) {
+	keys[pushed] = (u64)rand() % 64;
+	radixheap_push(&h, &keys[pushed], keys[pushed]);
+	pushed++;
+    }
+
+    u64 last = 0;
+    int popped = 0;
+    while (radixheap_size(&h) > 0) {
+	assert(radixheap_top_key(&h) >= last);
+	u64 key;
+	u64 *item = radixheap_pop(&h, &key);
+	assert(key >= last && *item == key);
+	last = key;
+	popped++;
+
+	for (int j = 0; j < 2 && pushed < 20000; j++) {
+	    keys[pushed] = key + (u64)(rand() % 1000);
+	    radixheap_push(&h, &keys[pushed], keys[pushed]);
+	    pushed++;
+	}
+    }
+    assert(popped == pushed);
+
+    /* a key below the last popped one is refused and the heap stays intact */
+    assert(radixheap_push(&h, &keys[0], last + 10));
+    assert(!radixheap_push(&h, &keys[0], last - 1));
+    assert(radixheap_size(&h) == 1 && radixheap_top_key(&h) == last + 10);
+    radixheap_free(&h);
+}
+
+void test_extreme_keys(void)
+{
+    RadixHeap h;
+    radixheap_init(&h);
+    u64 keys[] = { UINT64_MAX, 0, (u64)1 << 63, 1, UINT64_MAX, 0 };
+    for (int i = 0; i < 6; i++)
+	radixheap_push(&h, &keys[i], keys[i]);
+
+    u64 expected[] = { 0, 0, 1, (u64)1 << 63, UINT64_MAX, UINT64_MAX };
+    for (int i = 0; i < 6; i++) {
+	u64 key;
+	assert(radixheap_pop(&h, &key) != NULL);
+	assert(key == expected[i]);
+    }
+    assert(radixheap_pop(&h, NULL) == NULL);
+    radixheap_free(&h);
+}
+
+int main(void)
+{
+    test_order();
+    test_monotone();
+    test_extreme_keys();
+}
@@ -0,0 +1,98 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand, Callum Gran
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <string.h>
+
+#define NICC_TYPEDEF
+#include "../segarray.h"
+
+typedef struct {
+    int a;
+    double b;
+} Tuple;
+
+void test_append_get(void)
+{
+    /* SegArray will hold values of Tuple */
+    SegArray arr;
+    segarray_init(&arr, sizeof(Tuple));
+
+    for (int i = 0; i < 1000; i++)
+	segarray_append(&arr, &(Tuple){ .a = i, .b = i * 0.5 });
+
+    for (int i = 0; i < 1000; i++) {
+	Tuple *get = segarray_get(&arr, i);
+	assert(get->a == i);
+	assert(get->b == i * 0.5);
+    }
+    assert(segarray_get(&arr, 1000) == NULL);
+
+    segarray_free(&arr);
+}
+
+void test_stable_addresses(void)
+{
+    /* SegArray will hold values of Tuple */
+    SegArray arr;
+    segarray_init(&arr, sizeof(Tuple));
+
+    segarray_append(&arr, &(Tuple){ .a = 1, .b = 1.1 });
+    Tuple *first = segarray_get(&arr, 0);
+
+    /* many new chunks later the first element has not moved */
+    for (int i = 0; i < 10000; i++)
+	segarray_append(&arr, &(Tuple){ .a = 2, .b = 2.2 });
+
+    assert(first == segarray_get(&arr, 0));
+    assert(first->a == 1);
+
+    segarray_free(&arr);
+}
+
+void test_set_pop(void)
+{
+    /* SegArray will hold values of Tuple */
+    SegArray arr;
+    segarray_init(&arr, sizeof(Tuple));
+
+    bool rc = segarray_set(&arr, &(Tuple){ .a = 1, .b = 1.1 }, 1);
+    assert(!rc);
+
+    rc = segarray_set(&arr, &(Tuple){ .a = 1, .b = 1.1 }, 0);
+    assert(rc);
+    segarray_append(&arr, &(Tuple){ .a = 2, .b = 2.2 });
+
+    Tuple pop;
+    rc = segarray_pop_and_copy(&arr, &pop);
+    assert(rc);
+    assert(pop.a == 2);
+    assert(arr.size == 1);
+
+    rc = segarray_pop(&arr);
+    assert(rc);
+    rc = segarray_pop(&arr);
+    assert(!rc);
+
+    segarray_free(&arr);
+}
+
+int main(void)
+{
+    test_append_get();
+    test_stable_addresses();
+    test_set_pop();
+}
@@ -0,0 +1,136 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <string.h>
+
+#define NICC_TYPEDEF
+#include "../skiplist.h"
+
+static inline i32 int_cmp(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+void test_insert_find_remove(void)
+{
+    SkipList sl;
+    skiplist_init(&sl, int_cmp, false);
+
+    int keys[100];
+    char *values[] = { "even", "odd" };
+    /* insert in a scrambled order */
+    for (int i = 0; i < 100; i++) {
+	keys[i] = (i * 37) % 100;
+	bool rc = skiplist_insert(&sl, &keys[i], values[keys[i] % 2]);
+	assert(rc);
+    }
+    assert(sl.size == 100);
+
+    int key = 42;
+    assert(strcmp(skiplist_get(&sl, &key), "even") == 0);
+
+    /* keys come out in order */
+    int expected = 0;
+    for (SkipListNode *node = skiplist_first(&sl); node != NULL; node = skiplist_next(node))
+	assert(*(int *)node->key == expected++);
+    assert(expected == 100);
+
+    /* replacing an existing key */
+    bool rc = skiplist_insert(&sl, &key, values[1]);
+    assert(!rc);
+    assert(sl.size == 100);
+    assert(strcmp(skiplist_get(&sl, &key), "odd") == 0);
+
+    void *removed;
+    rc = skiplist_remove(&sl, &key, &removed);
+    assert(rc);
+    assert(strcmp(removed, "odd") == 0);
+    assert(skiplist_get(&sl, &key) == NULL);
+    rc = skiplist_remove(&sl, &key, NULL);
+    assert(!rc);
+
+    skiplist_free(&sl);
+}
+
+void test_floor_ceil_range(void)
+{
+    SkipList sl;
+    skiplist_init(&sl, int_cmp, false);
+
+    int keys[] = { 10, 20, 30, 40, 50 };
+    for (int i = 0; i < 5; i++)
+	skiplist_insert(&sl, &keys[i], NULL);
+
+    int key = 25;
+    assert(*(int *)skiplist_floor(&sl, &key)->key == 20);
+    assert(*(int *)skiplist_ceil(&sl, &key)->key == 30);
+    key = 5;
+    assert(skiplist_floor(&sl, &key) == NULL);
+    key = 50;
+    assert(*(int *)skiplist_floor(&sl, &key)->key == 50);
+    key = 51;
+    assert(skiplist_ceil(&sl, &key) == NULL);
+
+    int lo = 15;
+    int hi = 40;
+    struct skiplist_cursor_t cursor;
+    skiplist_range(&sl, &lo, &hi, &cursor);
+    assert(*(int *)skiplist_cursor_next(&cursor)->key == 20);
+    assert(*(int *)skiplist_cursor_next(&cursor)->key == 30);
+    assert(skiplist_cursor_next(&cursor) == NULL);
+
+    skiplist_free(&sl);
+}
+
+void test_rank_select(void)
+{
+    SkipList sl;
+    skiplist_init(&sl, int_cmp, true);
+
+    int keys[1000];
+    for (int i = 0; i < 1000; i++) {
+	keys[i] = (i * 7919) % 1000;
+	skiplist_insert(&sl, &keys[i], NULL);
+    }
+
+    /* remove the multiples of three */
+    for (int i = 0; i < 1000; i += 3) {
+	bool rc = skiplist_remove(&sl, &i, NULL);
+	assert(rc);
+    }
+
+    size_t idx = 0;
+    for (int k = 0; k < 1000; k++) {
+	if (k % 3 == 0) {
+	    assert(skiplist_rank(&sl, &k) == NICC_NOT_FOUND);
+	    continue;
+	}
+	assert(skiplist_rank(&sl, &k) == idx);
+	assert(*(int *)skiplist_select(&sl, idx)->key == k);
+	idx++;
+    }
+    assert(skiplist_select(&sl, idx) == NULL);
+
+    skiplist_free(&sl);
+}
+
+int main(void)
+{
+    test_insert_find_remove();
+    test_floor_ceil_range();
+    test_rank_select();
+}
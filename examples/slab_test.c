@@ -0,0 +1,111 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NICC_TYPEDEF
+#include "../slab.h"
+
+typedef struct {
+    int a;
+    double b;
+} Tuple;
+
+void test_alloc_release(void)
+{
+    Slab slab;
+    slab_init(&slab, sizeof(Tuple));
+
+    Tuple *items[1000];
+    for (int i = 0; i < 1000; i++) {
+	items[i] = slab_alloc(&slab);
+	assert((uintptr_t)items[i] % sizeof(void *) == 0);
+	items[i]->a = i;
+	items[i]->b = i * 0.5;
+    }
+
+    /* nothing was overwritten by later allocations */
+    for (int i = 0; i < 1000; i++)
+	assert(items[i]->a == i);
+
+    /* released objects are handed out again, most recent first */
+    slab_release(&slab, items[10]);
+    slab_release(&slab, items[20]);
+    assert(slab_alloc(&slab) == items[20]);
+    assert(slab_alloc(&slab) == items[10]);
+
+    slab_free(&slab);
+}
+
+void test_alignment(void)
+{
+    /* 24 bytes is not a multiple of the alignment of a long double */
+    Slab slab;
+    slab_init(&slab, 24);
+    for (int i = 0; i < 100; i++) {
+	long double *obj = slab_alloc(&slab);
+	assert((uintptr_t)obj % _Alignof(max_align_t) == 0);
+	*obj = i;
+    }
+    slab_free(&slab);
+}
+
+void test_adopt(void)
+{
+    Slab slab, other;
+    slab_init(&slab, sizeof(Tuple));
+    slab_init(&other, sizeof(Tuple));
+
+    Tuple *mine = slab_alloc(&slab);
+    slab_release(&slab, mine);
+    Tuple *theirs[3];
+    for (int i = 0; i < 3; i++)
+	theirs[i] = slab_alloc(&other);
+    slab_release(&other, theirs[0]);
+    slab_release(&other, theirs[2]);
+
+    slab_adopt(&slab, &other);
+    assert(other.chunks == NULL && other.free_list == NULL);
+
+    /* the slots released in other are handed out by slab, ahead of its own */
+    Tuple *got[3];
+    for (int i = 0; i < 3; i++)
+	got[i] = slab_alloc(&slab);
+    assert(got[0] == theirs[2] && got[1] == theirs[0] && got[2] == mine);
+    assert(slab.free_list == NULL);
+
+    /* an empty slab takes the free list over as is */
+    Slab empty;
+    slab_init(&empty, sizeof(Tuple));
+    slab_release(&slab, got[1]);
+    slab_adopt(&empty, &slab);
+    assert(slab_alloc(&empty) == got[1]);
+    slab_release(&empty, got[0]);
+    assert(slab_alloc(&empty) == got[0]);
+
+    slab_free(&empty);
+    slab_free(&slab);
+    slab_free(&other);
+}
+
+int main(void)
+{
+    test_alloc_release();
+    test_alignment();
+    test_adopt();
+}
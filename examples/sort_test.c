@@ -0,0 +1,216 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <string.h>
+
+#define NICC_TYPEDEF
+#include "../heapq.h"
+#include "../sort.h"
+
+typedef struct {
+    int key;
+    char payload[60];
+} Record;
+
+/* 16 bytes, swapped by the fixed size case of nicc_data_swap() */
+typedef struct {
+    u64 key;
+    u64 tag;
+} Pair;
+
+typedef void sort_fn_t(void *base, size_t nmemb, size_t size, compare_fn_t *cmp);
+
+static i32 int_compare(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static i32 u64_compare(const void *a, const void *b)
+{
+    u64 x = *(const u64 *)a;
+    u64 y = *(const u64 *)b;
+    return (x > y) - (x < y);
+}
+
+static i32 pair_compare(const void *a, const void *b)
+{
+    return u64_compare(&((const Pair *)a)->key, &((const Pair *)b)->key);
+}
+
+static i32 record_compare(const void *a, const void *b)
+{
+    return int_compare(&((const Record *)a)->key, &((const Record *)b)->key);
+}
+
+enum pattern_t { RANDOM, FEW_KEYS, SORTED, REVERSED };
+
+static int key_for(enum pattern_t pattern, size_t i, size_t n)
+{
+    switch (pattern) {
+    case RANDOM:
+	return rand();
+    case FEW_KEYS:
+	return rand() % 4;
+    case SORTED:
+	return (int)i;
+    case REVERSED:
+	return (int)(n - i);
+    }
+    return 0;
+}
+
+static void check_sort(sort_fn_t *sort, size_t n, enum pattern_t pattern)
+{
+    int *ints = malloc(n * sizeof(int));
+    int *expected = malloc(n * sizeof(int));
+    u64 *wide = malloc(n * sizeof(u64));
+    Pair *pairs = malloc(n * sizeof(Pair));
+    Record *records = malloc(n * sizeof(Record));
+    for (size_t i = 0; i < n; i++) {
+	ints[i] = expected[i] = key_for(pattern, i, n);
+	wide[i] = (u64)ints[i] << 32;
+	pairs[i] = (Pair){ .key = wide[i], .tag = ~wide[i] };
+	records[i].key = ints[i];
+	memset(records[i].payload, ints[i] & 0xff, sizeof(records[i].payload));
+    }
+    qsort(expected, n, sizeof(int), int_compare);
+
+    sort(ints, n, sizeof(int), int_compare);
+    sort(wide, n, sizeof(u64), u64_compare);
+    sort(pairs, n, sizeof(Pair), pair_compare);
+    sort(records, n, sizeof(Record), record_compare);
+    for (size_t i = 0; i < n; i++) {
+	assert(ints[i] == expected[i]);
+	assert(wide[i] == (u64)expected[i] << 32);
+	assert(pairs[i].key == wide[i] && pairs[i].tag == ~wide[i]);
+	assert(records[i].key == expected[i]);
+	/* whole records were moved, not just the keys */
+	assert(records[i].payload[59] == (char)(expected[i] & 0xff));
+    }
+
+    free(ints);
+    free(expected);
+    free(wide);
+    free(pairs);
+    free(records);
+}
+
+void test_sorts(void)
+{
+    size_t sizes[] = { 0, 1, 2, 3, 17, 100, 1000, 20000 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+	for (enum pattern_t p = RANDOM; p <= REVERSED; p++) {
+	    check_sort(nicc_sort, sizes[s], p);
+	    check_sort(heap_sort_ascending, sizes[s], p);
+	}
+    }
+}
+
+void test_selection(void)
+{
+    size_t sizes[] = { 1, 2, 17, 100, 1000, 20000 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+	for (enum pattern_t p = RANDOM; p <= REVERSED; p++) {
+	    size_t n = sizes[s];
+	    int *ints = malloc(n * sizeof(int));
+	    int *expected = malloc(n * sizeof(int));
+	    for (size_t i = 0; i < n; i++)
+		expected[i] = key_for(p, i, n);
+	    qsort(expected, n, sizeof(int), int_compare);
+
+	    size_t nths[] = { 0, n / 3, n - 1 };
+	    for (int j = 0; j < 3; j++) {
+		size_t nth = nths[j];
+		for (size_t i = 0; i < n; i++)
+		    ints[i] = expected[(i * 7919) % n];
+		nicc_nth_element(ints, n, sizeof(int), nth, int_compare);
+		assert(ints[nth] == expected[nth]);
+		for (size_t i = 0; i < nth; i++)
+		    assert(ints[i] <= ints[nth]);
+		for (size_t i = nth + 1; i < n; i++)
+		    assert(ints[i] >= ints[nth]);
+
+		size_t k = nth + 1;
+		nicc_partial_sort(ints, n, sizeof(int), k, int_compare);
+		for (size_t i = 0; i < k; i++)
+		    assert(ints[i] == expected[i]);
+	    }
+
+	    free(ints);
+	    free(expected);
+	}
+    }
+}
+
+void test_arraylist_selection(void)
+{
+    ArrayList arr;
+    arraylist_init(&arr, sizeof(int));
+    assert(!arraylist_partial_sort(&arr, 3, int_compare));
+
+    /* 0..999 shuffled */
+    for (int i = 0; i < 1000; i++)
+	arraylist_append(&arr, &(int){ (i * 7919) % 1000 });
+
+    assert(!arraylist_nth_element(&arr, 1000, int_compare));
+    assert(arraylist_nth_element(&arr, 500, int_compare));
+    assert(*(int *)arraylist_get(&arr, 500) == 500);
+    for (size_t i = 0; i < 500; i++)
+	assert(*(int *)arraylist_get(&arr, i) < 500);
+
+    assert(arraylist_partial_sort(&arr, 10, int_compare));
+    for (size_t i = 0; i < 10; i++)
+	assert(*(int *)arraylist_get(&arr, i) == (int)i);
+
+    arraylist_free(&arr);
+}
+
+void test_heap_sort_descending(void)
+{
+    int ints[1000];
+    for (int i = 0; i < 1000; i++)
+	ints[i] = rand() % 100;
+
+    heap_sort(ints, 1000, sizeof(int), int_compare);
+    for (int i = 1; i < 1000; i++)
+	assert(ints[i - 1] >= ints[i]);
+}
+
+void test_heap_sort_large(void)
+{
+    /* far larger than any stack, heap_sort() used to copy the input into a VLA */
+    size_t n = 4 << 20;
+    u64 *wide = malloc(n * sizeof(u64));
+    for (size_t i = 0; i < n; i++)
+	wide[i] = ((u64)rand() << 31) ^ (u64)rand();
+
+    heap_sort(wide, n, sizeof(u64), u64_compare);
+    for (size_t i = 1; i < n; i++)
+	assert(wide[i - 1] >= wide[i]);
+    free(wide);
+}
+
+int main(void)
+{
+    test_sorts();
+    test_selection();
+    test_arraylist_selection();
+    test_heap_sort_descending();
+    test_heap_sort_large();
+}
@@ -0,0 +1,182 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/*
+ * Connection timeouts: every connection has an idle timeout that is pushed back
+ * whenever it sees activity, so most timeouts are cancelled long before they
+ * fire. Compares timerwheel_t against heapq_t used as a timer queue, both with
+ * lazy deletion (push a new entry, skip stale ones on pop) and as an indexed
+ * heap that moves the existing entry.
+ * cc -O2 timerwheel_bench.c ../timerwheel.c ../heapq.c ../common.c
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../heapq.h"
+#include "../timerwheel.h"
+
+#define N_CONNS 1000000
+#define ACTIVITY 20000000 // activity events, the clock ticks once per ACTIVITY_PER_TICK
+#define ACTIVITY_PER_TICK 100
+#define IDLE_TIMEOUT 30000 // ticks
+
+struct conn_t {
+    struct timerwheel_timer_t timer;
+    u32 handle; // indexed heap
+    u32 generation; // lazy heap, bumped whenever the timeout moves
+};
+
+struct lazy_entry_t {
+    u32 conn;
+    u32 generation;
+};
+
+static struct conn_t conns[N_CONNS];
+#define RNG_SEED 88172645463325252ull
+
+static u64 rng;
+static size_t expired;
+
+static u32 random_conn(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (u32)((rng >> 32) % N_CONNS);
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void on_timeout(struct timerwheel_timer_t *timer, void *ctx)
+{
+    struct timerwheel_t *wheel = ctx;
+    /* the connection is closed and a new one takes its place */
+    expired++;
+    timerwheel_schedule(wheel, timer, wheel->now + IDLE_TIMEOUT);
+}
+
+static double bench_timerwheel(void)
+{
+    rng = RNG_SEED;
+    struct timerwheel_t wheel;
+    timerwheel_init(&wheel, 0);
+    for (u32 i = 0; i < N_CONNS; i++) {
+	timerwheel_timer_init(&conns[i].timer);
+	timerwheel_schedule(&wheel, &conns[i].timer, i % IDLE_TIMEOUT + 1);
+    }
+
+    double start = now();
+    for (size_t i = 0; i < ACTIVITY; i++) {
+	u32 c = random_conn();
+	timerwheel_schedule(&wheel, &conns[c].timer, wheel.now + IDLE_TIMEOUT);
+	if (i % ACTIVITY_PER_TICK == 0)
+	    timerwheel_advance(&wheel, wheel.now + 1, on_timeout, &wheel);
+    }
+    return now() - start;
+}
+
+static double bench_heapq_lazy(size_t *peak)
+{
+    rng = RNG_SEED;
+    struct heapq_t hq;
+    heapq_init_copy(&hq, sizeof(struct lazy_entry_t), NULL);
+    for (u32 i = 0; i < N_CONNS; i++) {
+	conns[i].generation = 0;
+	struct lazy_entry_t e = { .conn = i, .generation = 0 };
+	heapq_push_copy_key(&hq, &e, i % IDLE_TIMEOUT + 1);
+    }
+
+    u64 clock = 0;
+    *peak = 0;
+    double start = now();
+    for (size_t i = 0; i < ACTIVITY; i++) {
+	u32 c = random_conn();
+	struct lazy_entry_t e = { .conn = c, .generation = ++conns[c].generation };
+	heapq_push_copy_key(&hq, &e, clock + IDLE_TIMEOUT);
+	if ((size_t)hq.size > *peak)
+	    *peak = (size_t)hq.size;
+
+	if (i % ACTIVITY_PER_TICK != 0)
+	    continue;
+	clock++;
+	while (hq.size > 0 && heapq_top_key(&hq) <= clock) {
+	    heapq_pop_copy(&hq, &e);
+	    if (e.generation != conns[e.conn].generation)
+		continue; // moved since, stale entry
+	    expired++;
+	    e.generation = ++conns[e.conn].generation;
+	    heapq_push_copy_key(&hq, &e, clock + IDLE_TIMEOUT);
+	}
+    }
+    double elapsed = now() - start;
+    heapq_free(&hq);
+    return elapsed;
+}
+
+static double bench_heapq_indexed(void)
+{
+    rng = RNG_SEED;
+    struct heapq_indexed_t hq;
+    heapq_indexed_init(&hq);
+    for (u32 i = 0; i < N_CONNS; i++)
+	conns[i].handle = heapq_indexed_push(&hq, &conns[i], i % IDLE_TIMEOUT + 1);
+
+    u64 clock = 0;
+    double start = now();
+    for (size_t i = 0; i < ACTIVITY; i++) {
+	u32 c = random_conn();
+	heapq_indexed_increase_key(&hq, conns[c].handle, clock + IDLE_TIMEOUT);
+
+	if (i % ACTIVITY_PER_TICK != 0)
+	    continue;
+	clock++;
+	u32 top;
+	while ((top = heapq_indexed_top(&hq)) != HEAPQ_NO_HANDLE &&
+	       heapq_indexed_key(&hq, top) <= clock) {
+	    expired++;
+	    heapq_indexed_increase_key(&hq, top, clock + IDLE_TIMEOUT);
+	}
+    }
+    double elapsed = now() - start;
+    heapq_indexed_free(&hq);
+    return elapsed;
+}
+
+int main(void)
+{
+    size_t peak;
+    printf("%d connections, %d activity events\n", N_CONNS, ACTIVITY);
+
+    expired = 0;
+    double t = bench_timerwheel();
+    printf("%-16s %8.3fs %10zu expired\n", "timerwheel_t", t, expired);
+
+    expired = 0;
+    t = bench_heapq_lazy(&peak);
+    printf("%-16s %8.3fs %10zu expired, heap peaked at %zu entries\n", "heapq_t lazy", t, expired,
+	   peak);
+
+    expired = 0;
+    t = bench_heapq_indexed();
+    printf("%-16s %8.3fs %10zu expired\n", "heapq_indexed_t", t, expired);
+}
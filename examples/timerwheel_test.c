@@ -0,0 +1,132 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <stdlib.h>
+
+#define NICC_TYPEDEF
+#include "../timerwheel.h"
+
+#define N_CONNS 2000
+
+typedef struct {
+    int id;
+    u64 deadline; // expected expiry, 0 if not scheduled
+    int fired;
+    TimerWheelTimer timeout;
+} Conn;
+
+typedef struct {
+    TimerWheel *wheel;
+    u64 last_fired;
+    bool rearm;
+} FireCtx;
+
+static void on_timeout(TimerWheelTimer *timer, void *arg)
+{
+    FireCtx *ctx = arg;
+    Conn *c = NICC_CONTAINER_OF(timer, Conn, timeout);
+    assert(!timerwheel_pending(timer));
+    /* fires on its own tick, and in order of expiry */
+    assert(timer->expires == c->deadline && ctx->wheel->now == c->deadline);
+    assert(c->deadline >= ctx->last_fired);
+    ctx->last_fired = c->deadline;
+    c->deadline = 0;
+    c->fired++;
+
+    if (ctx->rearm) {
+	c->deadline = ctx->wheel->now + 1 + (u64)(rand() % 100);
+	timerwheel_schedule(ctx->wheel, timer, c->deadline);
+    }
+}
+
+void test_random(void)
+{
+    static Conn conns[N_CONNS];
+    TimerWheel wheel;
+    timerwheel_init(&wheel, 1000);
+    for (int i = 0; i < N_CONNS; i++) {
+	conns[i] = (Conn){ .id = i };
+	timerwheel_timer_init(&conns[i].timeout);
+    }
+
+    FireCtx ctx = { .wheel = &wheel };
+    size_t scheduled = 0;
+    for (int round = 0; round < 2000; round++) {
+	for (int k = 0; k < 20; k++) {
+	    Conn *c = &conns[rand() % N_CONNS];
+	    if (rand() % 4 == 0) {
+		assert(timerwheel_cancel(&wheel, &c->timeout) == (c->deadline != 0));
+		scheduled -= c->deadline != 0;
+		c->deadline = 0;
+		continue;
+	    }
+
+	    /* mostly short timeouts, some far beyond the reach of the wheel */
+	    u64 delay = rand() % 8 == 0 ? ((u64)rand() << 8) : (u64)(rand() % 5000);
+	    scheduled += c->deadline == 0;
+	    c->deadline = wheel.now + (delay == 0 ? 1 : delay);
+	    timerwheel_schedule(&wheel, &c->timeout, c->deadline);
+	}
+	assert(wheel.size == scheduled);
+
+	u64 to = wheel.now + (u64)(rand() % (round % 100 == 0 ? 100000 : 300));
+	size_t due = 0;
+	for (int i = 0; i < N_CONNS; i++)
+	    due += conns[i].deadline != 0 && conns[i].deadline <= to;
+
+	ctx.last_fired = 0;
+	assert(timerwheel_advance(&wheel, to, on_timeout, &ctx) == due);
+	assert(wheel.now == to);
+	scheduled -= due;
+	for (int i = 0; i < N_CONNS; i++)
+	    assert(conns[i].deadline == 0 || conns[i].deadline > to);
+    }
+
+    /* everything still pending fires eventually, even from beyond the wheel range */
+    ctx.last_fired = 0;
+    assert(timerwheel_advance(&wheel, UINT64_MAX / 2, on_timeout, &ctx) == scheduled);
+    assert(wheel.size == 0);
+}
+
+void test_rearm_in_callback(void)
+{
+    static Conn conns[100];
+    TimerWheel wheel;
+    timerwheel_init(&wheel, 0);
+    for (int i = 0; i < 100; i++) {
+	conns[i] = (Conn){ .id = i, .deadline = (u64)(1 + i) };
+	timerwheel_timer_init(&conns[i].timeout);
+	timerwheel_schedule(&wheel, &conns[i].timeout, conns[i].deadline);
+    }
+
+    FireCtx ctx = { .wheel = &wheel, .rearm = true };
+    size_t fired = 0;
+    for (u64 t = 1; t <= 10000; t++)
+	fired += timerwheel_advance(&wheel, t, on_timeout, &ctx);
+    assert(wheel.size == 100);
+
+    size_t total = 0;
+    for (int i = 0; i < 100; i++)
+	total += (size_t)conns[i].fired;
+    assert(total == fired && fired > 10000);
+}
+
+int main(void)
+{
+    test_random();
+    test_rearm_in_callback();
+}
@@ -0,0 +1,146 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NICC_TYPEDEF
+#include "../topk.h"
+
+typedef struct {
+    int score;
+    int id;
+} Entry;
+
+static i32 int_compare(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static i32 int_compare_desc(const void *a, const void *b)
+{
+    return int_compare(b, a);
+}
+
+static i32 entry_compare(const void *a, const void *b)
+{
+    return int_compare(&((const Entry *)a)->score, &((const Entry *)b)->score);
+}
+
+void test_top_k(void)
+{
+    size_t n = 100000;
+    int *scores = malloc(n * sizeof(int));
+    TopK t;
+    nicc_topk_init(&t, 100, sizeof(Entry), entry_compare);
+    for (size_t i = 0; i < n; i++) {
+	scores[i] = rand();
+	nicc_topk_push(&t, &(Entry){ .score = scores[i], .id = (int)i });
+    }
+    assert(nicc_topk_size(&t) == 100);
+
+    /* the threshold is the worst kept item, so anything not above it is rejected */
+    const Entry *threshold = nicc_topk_threshold(&t);
+    assert(threshold != NULL);
+    assert(!nicc_topk_push(&t, &(Entry){ .score = threshold->score, .id = -1 }));
+
+    Entry out[100];
+    assert(nicc_topk_sorted(&t, out, NULL) == 100);
+    assert(nicc_topk_size(&t) == 0);
+
+    qsort(scores, n, sizeof(int), int_compare_desc);
+    for (int i = 0; i < 100; i++) {
+	assert(out[i].score == scores[i]);
+	assert(out[i].id != -1);
+    }
+
+    free(scores);
+    nicc_topk_free(&t);
+}
+
+void test_top_k_smallest(void)
+{
+    /* a reversed cmp keeps the k smallest instead */
+    TopK t;
+    nicc_topk_init(&t, 5, sizeof(int), int_compare_desc);
+    for (int i = 100; i > 0; i--)
+	nicc_topk_push(&t, &i);
+
+    int out[5];
+    assert(nicc_topk_sorted(&t, out, NULL) == 5);
+    for (int i = 0; i < 5; i++)
+	assert(out[i] == i + 1);
+    nicc_topk_free(&t);
+}
+
+void test_short_stream(void)
+{
+    TopK t;
+    nicc_topk_init(&t, 10, sizeof(int), int_compare);
+    assert(nicc_topk_threshold(&t) == NULL);
+    for (int i = 0; i < 3; i++)
+	assert(nicc_topk_push(&t, &i));
+    assert(nicc_topk_threshold(&t) == NULL);
+
+    int out[10];
+    assert(nicc_topk_sorted(&t, out, NULL) == 3);
+    assert(out[0] == 2 && out[1] == 1 && out[2] == 0);
+
+    /* the selector can be refilled after it was drained */
+    for (int i = 0; i < 20; i++)
+	nicc_topk_push(&t, &i);
+    assert(nicc_topk_sorted(&t, out, NULL) == 10);
+    assert(out[0] == 19 && out[9] == 10);
+    nicc_topk_free(&t);
+
+    nicc_topk_init(&t, 0, sizeof(int), int_compare);
+    assert(!nicc_topk_push(&t, &(int){ 1 }));
+    assert(nicc_topk_size(&t) == 0);
+    nicc_topk_free(&t);
+}
+
+void test_keyed(void)
+{
+    TopK t;
+    nicc_topk_init(&t, 50, sizeof(u32), NULL);
+    assert(nicc_topk_threshold_key(&t) == 0);
+    for (u32 i = 0; i < 10000; i++) {
+	u64 key = ((u64)i * 7919) % 10000;
+	nicc_topk_push_key(&t, &i, key);
+    }
+    assert(nicc_topk_threshold_key(&t) == 9950);
+    assert(!nicc_topk_push_key(&t, &(u32){ 0 }, 9950));
+
+    u32 out[50];
+    u64 keys[50];
+    assert(nicc_topk_sorted(&t, out, keys) == 50);
+    for (int i = 0; i < 50; i++) {
+	assert(keys[i] == (u64)(9999 - i));
+	assert(((u64)out[i] * 7919) % 10000 == keys[i]);
+    }
+    nicc_topk_free(&t);
+}
+
+int main(void)
+{
+    test_top_k();
+    test_top_k_smallest();
+    test_short_stream();
+    test_keyed();
+}
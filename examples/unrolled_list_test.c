@@ -0,0 +1,138 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <string.h>
+
+#define NICC_TYPEDEF
+#include "../unrolled_list.h"
+
+typedef struct {
+    int a;
+    double b;
+} Tuple;
+
+void test_both_ends(void)
+{
+    UnrolledList ul;
+    unrolled_list_init(&ul, sizeof(Tuple));
+
+    for (int i = 0; i < 100; i++) {
+	unrolled_list_push_back(&ul, &(Tuple){ .a = i, .b = i * 0.5 });
+	unrolled_list_push_front(&ul, &(Tuple){ .a = -i - 1, .b = 0.0 });
+    }
+    assert(ul.size == 200);
+
+    for (int i = 0; i < 200; i++)
+	assert(((Tuple *)unrolled_list_get(&ul, i))->a == i - 100);
+
+    Tuple pop;
+    bool rc = unrolled_list_pop_front(&ul, &pop);
+    assert(rc && pop.a == -100);
+    rc = unrolled_list_pop_back(&ul, &pop);
+    assert(rc && pop.a == 99 && pop.b == 49.5);
+
+    unrolled_list_free(&ul);
+    rc = unrolled_list_pop_back(&ul, &pop);
+    assert(!rc);
+}
+
+void test_insert_remove_middle(void)
+{
+    UnrolledList ul;
+    unrolled_list_init(&ul, sizeof(int));
+
+    /* insert the odd numbers, then the even numbers in between */
+    for (int i = 1; i < 1000; i += 2)
+	unrolled_list_push_back(&ul, &i);
+    for (int i = 0; i < 1000; i += 2) {
+	bool rc = unrolled_list_insert(&ul, &i, (size_t)i);
+	assert(rc);
+    }
+
+    for (int i = 0; i < 1000; i++)
+	assert(*(int *)unrolled_list_get(&ul, i) == i);
+
+    /* remove every other element, which forces nodes to merge */
+    for (int i = 0; i < 500; i++) {
+	int removed;
+	bool rc = unrolled_list_remove(&ul, (size_t)i, &removed);
+	assert(rc && removed == 2 * i);
+    }
+
+    assert(ul.size == 500);
+    for (int i = 0; i < 500; i++)
+	assert(*(int *)unrolled_list_get(&ul, i) == 2 * i + 1);
+    assert(unrolled_list_get(&ul, 500) == NULL);
+
+    unrolled_list_free(&ul);
+}
+
+void test_large_elements(void)
+{
+    /* only a couple of these fit in the default node size */
+    typedef struct {
+	char bytes[200];
+    } Big;
+
+    UnrolledList ul;
+    unrolled_list_init(&ul, sizeof(Big));
+    assert(ul.node_cap >= UNROLLED_LIST_MIN_NODE_CAP);
+    assert(ul.node_bytes % UNROLLED_LIST_CACHE_LINE == 0);
+
+    Big big;
+    for (int i = 0; i < 20; i++) {
+	memset(&big, i, sizeof(big));
+	unrolled_list_push_back(&ul, &big);
+    }
+    assert(((Big *)unrolled_list_get(&ul, 13))->bytes[199] == 13);
+
+    unrolled_list_free(&ul);
+}
+
+void test_boundary_churn(void)
+{
+    UnrolledList ul;
+    unrolled_list_init(&ul, sizeof(int));
+    for (int i = 0; i < (int)ul.node_cap; i++)
+	unrolled_list_push_back(&ul, &i);
+
+    /* the tail is full, so every push opens a node and every pop empties it */
+    unrolled_list_push_back(&ul, &(int){ -1 });
+    assert(unrolled_list_pop_back(&ul, NULL));
+    struct unrolled_node_t *spare = ul.spare;
+    assert(spare != NULL);
+    for (int i = 0; i < 1000; i++) {
+	unrolled_list_push_back(&ul, &i);
+	/* the emptied node is reused instead of allocating a new one */
+	assert(ul.spare == NULL && ul.tail == spare);
+	int popped;
+	assert(unrolled_list_pop_back(&ul, &popped));
+	assert(popped == i && ul.spare == spare);
+    }
+    assert(ul.size == ul.node_cap);
+    assert(*(int *)unrolled_list_get(&ul, ul.size - 1) == (int)ul.node_cap - 1);
+
+    unrolled_list_free(&ul);
+}
+
+int main(void)
+{
+    test_both_ends();
+    test_insert_remove_middle();
+    test_boundary_churn();
+    test_large_elements();
+}
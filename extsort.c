@@ -0,0 +1,408 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arraylist.h"
+#include "common.h"
+#include "extsort.h"
+#include "heapq.h"
+
+/*
+ * A sorted run being merged, either in memory or in a spilled file. The current
+ * record of the run is copied into head, which is what the merge heapq points
+ * at, so the run is recovered from a popped item with NICC_CONTAINER_OF().
+ */
+struct merge_run_t {
+    const u8 *pos; // unmerged records of the front buffer
+    const u8 *end;
+    FILE *file; // NULL for an in-memory run
+    u8 *bufs[2];
+    u32 front;
+    size_t back_len; // records the reader put in the back buffer
+    bool back_ready;
+    bool back_requested;
+    _Alignas(max_align_t) u8 head[];
+};
+
+struct merge_t {
+    struct merge_run_t **runs;
+    u32 n_runs;
+    u32 T_size;
+    size_t block; // records per read buffer
+    bool error;
+    bool threaded; // false if there is no reader thread and runs are read in place
+    pthread_t reader_thread;
+    bool stop;
+    pthread_mutex_t lock;
+    pthread_cond_t work; // a back buffer was requested, or stop was set
+    pthread_cond_t done; // a back buffer was filled
+};
+
+/* returns NULL if the run or its read buffers could not be allocated */
+static struct merge_run_t *run_new(struct merge_t *m, const void *data, size_t n, FILE *file)
+{
+    struct merge_run_t *run = malloc(sizeof(struct merge_run_t) + m->T_size);
+    if (run == NULL)
+	return NULL;
+    run->pos = data;
+    run->end = (const u8 *)data + n * m->T_size;
+    run->file = file;
+    run->bufs[0] = NULL;
+    run->bufs[1] = NULL;
+    run->front = 1;
+    run->back_len = 0;
+    run->back_ready = false;
+    run->back_requested = false;
+    if (file != NULL) {
+	run->bufs[0] = malloc(m->block * m->T_size);
+	run->bufs[1] = malloc(m->block * m->T_size);
+	if (run->bufs[0] == NULL || run->bufs[1] == NULL) {
+	    free(run->bufs[0]);
+	    free(run->bufs[1]);
+	    free(run);
+	    return NULL;
+	}
+	/* the first block is read ahead before the merge asks for it */
+	run->back_requested = true;
+    }
+    return run;
+}
+
+static void run_free(struct merge_run_t *run)
+{
+    free(run->bufs[0]);
+    free(run->bufs[1]);
+    free(run);
+}
+
+/* fills requested back buffers until the merge sets stop */
+static void *reader(void *arg)
+{
+    struct merge_t *m = arg;
+    pthread_mutex_lock(&m->lock);
+    for (;;) {
+	struct merge_run_t *run = NULL;
+	for (u32 i = 0; i < m->n_runs && run == NULL; i++) {
+	    if (m->runs[i]->back_requested)
+		run = m->runs[i];
+	}
+	if (run == NULL) {
+	    if (m->stop)
+		break;
+	    pthread_cond_wait(&m->work, &m->lock);
+	    continue;
+	}
+
+	run->back_requested = false;
+	u8 *back = run->bufs[1 - run->front];
+	pthread_mutex_unlock(&m->lock);
+	size_t n = fread(back, m->T_size, m->block, run->file);
+	bool failed = n < m->block && ferror(run->file);
+	pthread_mutex_lock(&m->lock);
+	m->error |= failed;
+	run->back_len = n;
+	run->back_ready = true;
+	pthread_cond_broadcast(&m->done);
+    }
+    pthread_mutex_unlock(&m->lock);
+    return NULL;
+}
+
+/* without a reader thread the back buffer is filled here, and swapped in right away */
+static bool run_refill_sync(struct merge_t *m, struct merge_run_t *run)
+{
+    size_t n = fread(run->bufs[1 - run->front], m->T_size, m->block, run->file);
+    if (n < m->block && ferror(run->file))
+	m->error = true;
+    if (n == 0)
+	return false;
+
+    run->front = 1 - run->front;
+    run->pos = run->bufs[run->front];
+    run->end = run->pos + n * m->T_size;
+    return true;
+}
+
+/* swaps in the back buffer once the reader filled it. false at the end of the run */
+static bool run_refill(struct merge_t *m, struct merge_run_t *run)
+{
+    if (run->file == NULL)
+	return false;
+    if (!m->threaded)
+	return run_refill_sync(m, run);
+
+    pthread_mutex_lock(&m->lock);
+    while (!run->back_ready)
+	pthread_cond_wait(&m->done, &m->lock);
+    run->back_ready = false;
+    size_t n = run->back_len;
+    if (n == 0) {
+	pthread_mutex_unlock(&m->lock);
+	return false;
+    }
+
+    run->front = 1 - run->front;
+    run->pos = run->bufs[run->front];
+    run->end = run->pos + n * m->T_size;
+    /* a short block means the reader hit the end of the file, or an error */
+    if (n == m->block) {
+	run->back_requested = true;
+	pthread_cond_signal(&m->work);
+    } else {
+	run->back_len = 0;
+	run->back_ready = true;
+    }
+    pthread_mutex_unlock(&m->lock);
+    return true;
+}
+
+static bool run_next(struct merge_t *m, struct merge_run_t *run)
+{
+    if (run->pos == run->end && !run_refill(m, run))
+	return false;
+
+    memcpy(run->head, run->pos, m->T_size);
+    run->pos += m->T_size;
+    return true;
+}
+
+static void merge(struct merge_t *m, compare_fn_t *cmp, extsort_emit_fn_t *emit, void *ctx)
+{
+    bool spilled = false;
+    for (u32 i = 0; i < m->n_runs; i++)
+	spilled |= m->runs[i]->file != NULL;
+    if (spilled) {
+	m->stop = false;
+	pthread_mutex_init(&m->lock, NULL);
+	pthread_cond_init(&m->work, NULL);
+	pthread_cond_init(&m->done, NULL);
+	/* without a reader the runs are still merged, just without overlapping the reads */
+	m->threaded = pthread_create(&m->reader_thread, NULL, reader, m) == 0;
+	if (!m->threaded) {
+	    pthread_mutex_destroy(&m->lock);
+	    pthread_cond_destroy(&m->work);
+	    pthread_cond_destroy(&m->done);
+	}
+    }
+
+    struct heapq_t hq;
+    heapq_init(&hq, cmp);
+    for (u32 i = 0; i < m->n_runs; i++) {
+	if (run_next(m, m->runs[i]))
+	    heapq_push(&hq, m->runs[i]->head);
+    }
+
+    /* the smallest head is emitted and replaced by the next record of its run */
+    while (hq.size > 0) {
+	void *top = heapq_get(&hq, 0);
+	struct merge_run_t *run = NICC_CONTAINER_OF(top, struct merge_run_t, head);
+	emit(top, ctx);
+	if (run_next(m, run))
+	    heapq_replace(&hq, top);
+	else
+	    heapq_pop(&hq);
+    }
+    heapq_free(&hq);
+
+    if (m->threaded) {
+	pthread_mutex_lock(&m->lock);
+	m->stop = true;
+	pthread_cond_signal(&m->work);
+	pthread_mutex_unlock(&m->lock);
+	pthread_join(m->reader_thread, NULL);
+	pthread_mutex_destroy(&m->lock);
+	pthread_cond_destroy(&m->work);
+	pthread_cond_destroy(&m->done);
+    }
+}
+
+/* sets m->error if the run table could not be allocated */
+static void merge_init(struct merge_t *m, u32 n_runs, u32 T_size)
+{
+    m->runs = malloc(sizeof(struct merge_run_t *) * (n_runs > 0 ? n_runs : 1));
+    m->n_runs = 0;
+    m->T_size = T_size;
+    m->block = EXTSORT_BLOCK_BYTES / T_size;
+    if (m->block == 0)
+	m->block = 1;
+    m->error = m->runs == NULL;
+    m->threaded = false;
+}
+
+static void merge_add_run(struct merge_t *m, const void *data, size_t n, FILE *file)
+{
+    struct merge_run_t *run = run_new(m, data, n, file);
+    if (run == NULL)
+	m->error = true;
+    else
+	m->runs[m->n_runs++] = run;
+}
+
+static void merge_free(struct merge_t *m)
+{
+    for (u32 i = 0; i < m->n_runs; i++)
+	run_free(m->runs[i]);
+    free(m->runs);
+}
+
+bool extsort_init(struct extsort_t *s, u32 T_size, compare_fn_t *cmp, size_t memory_bytes)
+{
+    arraylist_init(&s->run, T_size);
+    s->run_capacity = memory_bytes / T_size;
+    if (s->run_capacity == 0)
+	s->run_capacity = 1;
+    s->cmp = cmp;
+    s->spilled = NULL;
+    s->n_spilled = 0;
+    s->spilled_capacity = 0;
+    s->radix_offset = 0;
+    s->radix_size = 0;
+    s->size = 0;
+    /* the run buffer is allocated once, a run is spilled before it would grow */
+    return arraylist_reserve(&s->run, s->run_capacity);
+}
+
+void extsort_free(struct extsort_t *s)
+{
+    arraylist_free(&s->run);
+    for (u32 i = 0; i < s->n_spilled; i++)
+	fclose(s->spilled[i]);
+    free(s->spilled);
+}
+
+void extsort_use_radix(struct extsort_t *s, size_t key_offset, u32 key_size)
+{
+    s->radix_offset = key_offset;
+    s->radix_size = key_size;
+}
+
+static void sort_run(struct extsort_t *s)
+{
+    if (s->radix_size != 0)
+	arraylist_radix_sort_u(&s->run, s->radix_offset, s->radix_size);
+    else
+	arraylist_sort(&s->run, s->cmp);
+}
+
+static bool spill_run(struct extsort_t *s)
+{
+    FILE *file = tmpfile();
+    if (file == NULL)
+	return false;
+
+    sort_run(s);
+    if (fwrite(s->run.data, s->run.T_size, s->run.size, file) != s->run.size) {
+	fclose(file);
+	return false;
+    }
+
+    if (s->n_spilled >= s->spilled_capacity) {
+	s->spilled_capacity = GROW_CAPACITY(s->spilled_capacity);
+	s->spilled = GROW_ARRAY(FILE *, s->spilled, s->spilled_capacity);
+    }
+    s->spilled[s->n_spilled++] = file;
+    s->run.size = 0;
+    return true;
+}
+
+bool extsort_push(struct extsort_t *s, const void *record)
+{
+    if (s->run.size >= s->run_capacity && !spill_run(s))
+	return false;
+
+    arraylist_append(&s->run, (void *)record);
+    s->size++;
+    return true;
+}
+
+bool extsort_finish(struct extsort_t *s, extsort_emit_fn_t *emit, void *ctx)
+{
+    struct merge_t m;
+    merge_init(&m, s->n_spilled + 1, s->run.T_size);
+    for (u32 i = 0; i < s->n_spilled && !m.error; i++) {
+	if (fflush(s->spilled[i]) != 0 || fseek(s->spilled[i], 0, SEEK_SET) != 0)
+	    m.error = true;
+	else
+	    merge_add_run(&m, NULL, 0, s->spilled[i]);
+    }
+    /* the last run never has to leave memory */
+    if (s->run.size > 0 && !m.error) {
+	sort_run(s);
+	merge_add_run(&m, s->run.data, s->run.size, NULL);
+    }
+
+    if (!m.error)
+	merge(&m, s->cmp, emit, ctx);
+    bool ok = !m.error;
+    merge_free(&m);
+    return ok;
+}
+
+struct emit_file_ctx_t {
+    FILE *out;
+    u32 T_size;
+};
+
+static void emit_file(const void *record, void *ctx)
+{
+    struct emit_file_ctx_t *c = ctx;
+    fwrite(record, c->T_size, 1, c->out);
+}
+
+bool extsort_finish_file(struct extsort_t *s, FILE *out)
+{
+    struct emit_file_ctx_t ctx = { out, s->run.T_size };
+    bool ok = extsort_finish(s, emit_file, &ctx);
+    return fflush(out) == 0 && !ferror(out) && ok;
+}
+
+struct emit_arraylist_ctx_t {
+    struct arraylist_t *out;
+    bool ok;
+};
+
+static void emit_arraylist(const void *record, void *ctx)
+{
+    struct emit_arraylist_ctx_t *c = ctx;
+    c->ok &= arraylist_append(c->out, (void *)record);
+}
+
+bool nicc_kway_merge(struct arraylist_t *lists, u32 k, compare_fn_t *cmp,
+		     struct arraylist_t *out)
+{
+    struct merge_t m;
+    merge_init(&m, k, out->T_size);
+    size_t total = out->size;
+    for (u32 i = 0; i < k && !m.error; i++) {
+	merge_add_run(&m, lists[i].data, lists[i].size, NULL);
+	total += lists[i].size;
+    }
+
+    /* out is grown up front, so a file backed out fails before anything is merged */
+    struct emit_arraylist_ctx_t ctx = { out, true };
+    if (!m.error && arraylist_reserve(out, total))
+	merge(&m, cmp, emit_arraylist, &ctx);
+    else
+	ctx.ok = false;
+    merge_free(&m);
+    return ctx.ok;
+}
@@ -0,0 +1,93 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef NICC_EXTSORT_H
+#define NICC_EXTSORT_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "arraylist.h"
+#include "common.h"
+
+#ifdef NICC_TYPEDEF
+typedef struct extsort_t ExtSort;
+#endif /* NICC_TYPEDEF */
+
+#define EXTSORT_BLOCK_BYTES (256 * 1024) // size of each of the two read buffers of a run
+
+/* called with every record in sorted order, with the ctx given to extsort_finish() */
+typedef void extsort_emit_fn_t(const void *record, void *ctx);
+
+/*
+ * External merge sort of fixed size records, for data that does not fit in memory.
+ *
+ * Records are pushed into a run buffer of memory_bytes. Whenever it fills up the
+ * run is sorted and spilled to an anonymous temporary file. extsort_finish() then
+ * sorts the last run in place, and merges every run with a heapq of the current
+ * record of each run, so the output needs one pass over the spilled data.
+ *
+ * Every run is read through two EXTSORT_BLOCK_BYTES buffers. While the merge
+ * consumes one, a reader thread fills the other, so reading overlaps merging.
+ * The merge is not stable.
+ */
+struct extsort_t {
+    struct arraylist_t run;
+    size_t run_capacity; // records per run
+    compare_fn_t *cmp;
+    FILE **spilled;
+    u32 n_spilled;
+    u32 spilled_capacity;
+    size_t radix_offset;
+    u32 radix_size; // 0 unless runs are radix sorted, see extsort_use_radix()
+    size_t size;
+};
+
+/*
+ * memory_bytes is the size of the run buffer, at least one record, which is
+ * reserved here. returns false if it could not be reserved.
+ */
+bool extsort_init(struct extsort_t *s, u32 T_size, compare_fn_t *cmp, size_t memory_bytes);
+/* closes, and so deletes, any spilled runs */
+void extsort_free(struct extsort_t *s);
+
+/*
+ * sorts the runs with arraylist_radix_sort_u() on the key_size byte unsigned key
+ * at key_offset instead of with cmp, which must still order records by that key
+ * as it is used for the merge.
+ */
+void extsort_use_radix(struct extsort_t *s, size_t key_offset, u32 key_size);
+
+/* returns false if a full run could not be spilled */
+bool extsort_push(struct extsort_t *s, const void *record);
+
+/*
+ * calls emit with every pushed record in sorted order, or writes them to out.
+ * can be called once, after which the extsort only has to be freed. returns
+ * false on a read or write error.
+ */
+bool extsort_finish(struct extsort_t *s, extsort_emit_fn_t *emit, void *ctx);
+bool extsort_finish_file(struct extsort_t *s, FILE *out);
+
+/*
+ * appends the k sorted arraylists, which must hold records of out->T_size bytes,
+ * merged in sorted order to out. returns false, without appending anything, if
+ * out could not be grown to hold every record.
+ */
+bool nicc_kway_merge(struct arraylist_t *lists, u32 k, compare_fn_t *cmp,
+		     struct arraylist_t *out);
+
+#endif /* NICC_EXTSORT_H */
@@ -94,7 +94,7 @@ static int insert(struct hm_bucket_t *bucket, struct hm_entry_t *new)
 	struct hm_entry_t *entry = &bucket->entries[i];
 	if (entry->key != NULL &&
 	    new->hash_extra == entry->hash_extra &&new->key_size == entry->key_size) {
-	    if (memcmp(new->key, entry->key, new->key_size) == 0) {
+	    if (nicc_data_eq(new->key, entry->key, new->key_size)) {
 		found = entry;
 		override = true;
 		break;
@@ -121,9 +121,7 @@ static struct hm_entry_t *get_from_bucket(struct hm_bucket_t *bucket, void *key,
         if (entry.key == NULL)
             continue;
 	if (key_size == entry.key_size && hash_extra == entry.hash_extra) {
-	    // TODO: instead of memcmp, use a function that exits if a byte is not
-	    // equal
-	    if (memcmp(key, entry.key, key_size) == 0)
+	    if (nicc_data_eq(key, entry.key, key_size))
 		return &bucket->entries[i];
 	}
     }
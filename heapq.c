@@ -18,58 +18,178 @@
 
 #include <string.h>
 
-static inline void *heapq_left_child(struct heapq_t *hq, int idx)
+#define HEAPQ_ALIGN 64 // cache line size
+
+/*
+ * every array of a heapq is preceded by arity - 1 unused slots. the children of
+ * idx then start at slot arity * (idx + 1), so with an aligned allocation a
+ * group of siblings never straddles more cache lines than it has to.
+ */
+static inline size_t arity_pad(u8 arity_log2)
+{
+    return ((size_t)1 << arity_log2) - 1;
+}
+
+static void *heapq_array_alloc(u8 arity_log2, size_t capacity, size_t elem_size)
 {
-    return hq->items[heapq_left_child_idx(idx)];
+    size_t bytes = (arity_pad(arity_log2) + capacity) * elem_size;
+    u8 *mem = nicc_internal_aligned_alloc(HEAPQ_ALIGN, bytes);
+    return mem + arity_pad(arity_log2) * elem_size;
 }
 
-static inline void *heapq_right_child(struct heapq_t *hq, int idx)
+static void heapq_array_free(u8 arity_log2, void *arr, size_t elem_size)
 {
-    return hq->items[heapq_right_child_idx(idx)];
+    if (arr != NULL)
+	free((u8 *)arr - arity_pad(arity_log2) * elem_size);
 }
 
-static inline void *heapq_parent(struct heapq_t *hq, int idx)
+/* moves the first used elements of arr into a new array of the given capacity */
+static void *heapq_array_grow(u8 arity_log2, void *arr, size_t used, size_t capacity,
+			      size_t elem_size)
 {
-    return hq->items[heapq_parent_idx(idx)];
+    void *grown = heapq_array_alloc(arity_log2, capacity, elem_size);
+    memcpy(grown, arr, used * elem_size);
+    heapq_array_free(arity_log2, arr, elem_size);
+    return grown;
+}
+
+static inline void *heapq_elem(struct heapq_t *hq, int idx)
+{
+    return hq->values + (size_t)idx * hq->T_size;
+}
+
+/* compares the items at index a and b in whichever way the heapq stores them */
+static inline i32 heapq_cmp(struct heapq_t *hq, int a, int b)
+{
+    if (hq->values == NULL)
+	return hq->cmp(hq->items[a], hq->items[b]);
+    if (hq->keys != NULL)
+	return (hq->keys[a] > hq->keys[b]) - (hq->keys[a] < hq->keys[b]);
+    return hq->cmp(heapq_elem(hq, a), heapq_elem(hq, b));
 }
 
 static void heapq_swap(struct heapq_t *hq, int a, int b)
 {
-    void *tmp = hq->items[a];
-    hq->items[a] = hq->items[b];
-    hq->items[b] = tmp;
+    if (hq->values == NULL) {
+	void *tmp = hq->items[a];
+	hq->items[a] = hq->items[b];
+	hq->items[b] = tmp;
+	return;
+    }
+
+    nicc_data_swap(heapq_elem(hq, a), heapq_elem(hq, b), hq->T_size);
+    if (hq->keys != NULL) {
+	u64 tmp = hq->keys[a];
+	hq->keys[a] = hq->keys[b];
+	hq->keys[b] = tmp;
+    }
 }
 
-static void heapify_up(struct heapq_t *hq)
+static void heapify_up(struct heapq_t *hq, int idx)
 {
-    int idx = hq->size - 1;
-    int parent_idx = heapq_parent_idx(idx);
+    int parent_idx = heapq_dary_parent_idx(idx, hq->arity_log2);
     /* keep "repearing" heap as long as parent is greater than child */
-    while (parent_idx >= 0 && hq->cmp(hq->items[parent_idx], hq->items[idx]) > 0) {
+    while (idx > 0 && heapq_cmp(hq, parent_idx, idx) > 0) {
 	heapq_swap(hq, parent_idx, idx);
 	/* walk upwards */
-	idx = heapq_parent_idx(idx);
-	parent_idx = heapq_parent_idx(idx);
+	idx = parent_idx;
+	parent_idx = heapq_dary_parent_idx(idx, hq->arity_log2);
+    }
+}
+
+/* index of the smallest of the children in [first, end) */
+static inline size_t heapq_min_child(struct heapq_t *hq, size_t first, size_t end)
+{
+    size_t min_idx = first;
+    if (hq->keys != NULL) {
+	/* keyed heapq, scan the sibling keys without any indirection */
+	u64 min_key = hq->keys[first];
+	for (size_t c = first + 1; c < end; c++) {
+	    if (hq->keys[c] < min_key) {
+		min_key = hq->keys[c];
+		min_idx = c;
+	    }
+	}
+	return min_idx;
+    }
+
+    for (size_t c = first + 1; c < end; c++) {
+	if (heapq_cmp(hq, (int)min_idx, (int)c) > 0)
+	    min_idx = c;
     }
+    return min_idx;
 }
 
-static void heapify_down(struct heapq_t *hq)
+static void heapify_down(struct heapq_t *hq, int idx)
 {
-    int idx = 0;
-    int min_idx;
-    while (heapq_has_left(idx, hq->size)) {
-	min_idx = heapq_left_child_idx(idx);
-	if (heapq_has_right(idx, hq->size) &&
-	    hq->cmp(hq->items[min_idx], heapq_right_child(hq, idx)) > 0)
-	    min_idx = heapq_right_child_idx(idx);
+    size_t size = (size_t)hq->size;
+    size_t first;
+    while ((first = heapq_dary_first_child_idx((size_t)idx, hq->arity_log2)) < size) {
+	size_t end = first + ((size_t)1 << hq->arity_log2);
+	if (end > size)
+	    end = size;
+	int min_idx = (int)heapq_min_child(hq, first, end);
 
-	if (hq->cmp(hq->items[min_idx], hq->items[idx]) > 0) {
+	if (heapq_cmp(hq, min_idx, idx) >= 0)
 	    break;
-	} else {
-	    heapq_swap(hq, idx, min_idx);
-	    idx = min_idx;
-	}
+	heapq_swap(hq, idx, min_idx);
+	idx = min_idx;
+    }
+}
+
+/* grows the arrays so they hold at least min_capacity items */
+static void heapq_reserve(struct heapq_t *hq, int min_capacity)
+{
+    if (min_capacity <= hq->capacity)
+	return;
+    while (hq->capacity < min_capacity)
+	hq->capacity = GROW_CAPACITY(hq->capacity);
+
+    u8 arity_log2 = hq->arity_log2;
+    size_t size = (size_t)hq->size;
+    size_t capacity = (size_t)hq->capacity;
+    if (hq->values == NULL) {
+	hq->items = heapq_array_grow(arity_log2, hq->items, size, capacity, sizeof(void *));
+	return;
+    }
+
+    hq->values = heapq_array_grow(arity_log2, hq->values, size, capacity, hq->T_size);
+    if (hq->keys != NULL)
+	hq->keys = heapq_array_grow(arity_log2, hq->keys, size, capacity, sizeof(u64));
+}
+
+static void heapq_move(struct heapq_t *hq, int dst, int src)
+{
+    if (hq->values == NULL) {
+	hq->items[dst] = hq->items[src];
+	return;
+    }
+
+    memcpy(heapq_elem(hq, dst), heapq_elem(hq, src), hq->T_size);
+    if (hq->keys != NULL)
+	hq->keys[dst] = hq->keys[src];
+}
+
+/* Floyd's bottom-up heap construction, sifts every inner node from the last one up */
+static void heapq_build(struct heapq_t *hq)
+{
+    if (hq->size < 2)
+	return;
+    for (int idx = heapq_dary_parent_idx(hq->size - 1, hq->arity_log2); idx >= 0; idx--)
+	heapify_down(hq, idx);
+}
+
+/* (re)allocates the empty arrays of the heapq for its current mode and arity */
+static void heapq_alloc_arrays(struct heapq_t *hq)
+{
+    if (hq->T_size == 0) {
+	hq->items = heapq_array_alloc(hq->arity_log2, hq->capacity, sizeof(void *));
+	return;
     }
+
+    hq->values = heapq_array_alloc(hq->arity_log2, hq->capacity, hq->T_size);
+    if (hq->cmp == NULL)
+	hq->keys = heapq_array_alloc(hq->arity_log2, hq->capacity, sizeof(u64));
 }
 
 void *heapq_get(struct heapq_t *hq, int idx)
@@ -77,75 +197,580 @@ void *heapq_get(struct heapq_t *hq, int idx)
     if (idx < 0 || idx >= hq->size)
 	return NULL;
 
+    if (hq->values != NULL)
+	return heapq_elem(hq, idx);
     return hq->items[idx];
 }
 
 void *heapq_pop(struct heapq_t *hq)
 {
-    struct node_t *item = heapq_get(hq, 0);
+    if (hq->values != NULL)
+	return NULL;
+
+    void *item = heapq_get(hq, 0);
     if (item == NULL)
 	return NULL;
 
     hq->items[0] = hq->items[--hq->size];
-    heapify_down(hq);
+    heapify_down(hq, 0);
     return item;
 }
 
-void heapq_push(struct heapq_t *hq, void *item)
+bool heapq_push(struct heapq_t *hq, void *item)
 {
-    if (hq->size >= hq->capacity) {
-	hq->capacity = GROW_CAPACITY(hq->capacity);
-	hq->items = GROW_ARRAY(void *, hq, hq->capacity);
-    }
+    if (hq->values != NULL)
+	return false;
+
+    heapq_reserve(hq, hq->size + 1);
     hq->items[hq->size++] = item;
-    heapify_up(hq);
+    heapify_up(hq, hq->size - 1);
+    return true;
+}
+
+void heapq_push_copy(struct heapq_t *hq, const void *item)
+{
+    heapq_reserve(hq, hq->size + 1);
+    memcpy(heapq_elem(hq, hq->size++), item, hq->T_size);
+    heapify_up(hq, hq->size - 1);
+}
+
+void heapq_push_copy_key(struct heapq_t *hq, const void *item, u64 key)
+{
+    heapq_reserve(hq, hq->size + 1);
+    memcpy(heapq_elem(hq, hq->size), item, hq->T_size);
+    hq->keys[hq->size++] = key;
+    heapify_up(hq, hq->size - 1);
+}
+
+bool heapq_pop_copy(struct heapq_t *hq, void *return_ptr)
+{
+    if (hq->size == 0)
+	return false;
+
+    if (return_ptr != NULL)
+	memcpy(return_ptr, heapq_elem(hq, 0), hq->T_size);
+    if (--hq->size > 0) {
+	heapq_swap(hq, 0, hq->size);
+	heapify_down(hq, 0);
+    }
+    return true;
+}
+
+/*
+ * places a copy of item (and its key) in the unused slot right after the last
+ * item, where the pushpop and replace functions pick it up with a single sift
+ */
+static void heapq_stage_copy(struct heapq_t *hq, const void *item, u64 key)
+{
+    heapq_reserve(hq, hq->size + 1);
+    memcpy(heapq_elem(hq, hq->size), item, hq->T_size);
+    if (hq->keys != NULL)
+	hq->keys[hq->size] = key;
+}
+
+static void heapq_pushpop_staged(struct heapq_t *hq, void *return_ptr)
+{
+    int staged = hq->size;
+    if (hq->size == 0 || heapq_cmp(hq, staged, 0) <= 0) {
+	/* the new item would be popped right away, the heap is untouched */
+	if (return_ptr != NULL)
+	    memcpy(return_ptr, heapq_elem(hq, staged), hq->T_size);
+	return;
+    }
+
+    if (return_ptr != NULL)
+	memcpy(return_ptr, heapq_elem(hq, 0), hq->T_size);
+    heapq_move(hq, 0, staged);
+    heapify_down(hq, 0);
+}
+
+static bool heapq_replace_staged(struct heapq_t *hq, void *return_ptr)
+{
+    if (hq->size == 0) {
+	hq->size++;
+	return false;
+    }
+
+    if (return_ptr != NULL)
+	memcpy(return_ptr, heapq_elem(hq, 0), hq->T_size);
+    heapq_move(hq, 0, hq->size);
+    heapify_down(hq, 0);
+    return true;
+}
+
+void *heapq_pushpop(struct heapq_t *hq, void *item)
+{
+    if (hq->values != NULL)
+	return NULL;
+    if (hq->size == 0 || hq->cmp(item, hq->items[0]) <= 0)
+	return item;
+
+    void *top = hq->items[0];
+    hq->items[0] = item;
+    heapify_down(hq, 0);
+    return top;
+}
+
+void *heapq_replace(struct heapq_t *hq, void *item)
+{
+    if (hq->values != NULL)
+	return NULL;
+    if (hq->size == 0) {
+	heapq_push(hq, item);
+	return NULL;
+    }
+
+    void *top = hq->items[0];
+    hq->items[0] = item;
+    heapify_down(hq, 0);
+    return top;
+}
+
+void heapq_pushpop_copy(struct heapq_t *hq, const void *item, void *return_ptr)
+{
+    heapq_stage_copy(hq, item, 0);
+    heapq_pushpop_staged(hq, return_ptr);
+}
+
+void heapq_pushpop_copy_key(struct heapq_t *hq, const void *item, u64 key, void *return_ptr)
+{
+    heapq_stage_copy(hq, item, key);
+    heapq_pushpop_staged(hq, return_ptr);
+}
+
+bool heapq_replace_copy(struct heapq_t *hq, const void *item, void *return_ptr)
+{
+    heapq_stage_copy(hq, item, 0);
+    return heapq_replace_staged(hq, return_ptr);
+}
+
+bool heapq_replace_copy_key(struct heapq_t *hq, const void *item, u64 key, void *return_ptr)
+{
+    heapq_stage_copy(hq, item, key);
+    return heapq_replace_staged(hq, return_ptr);
+}
+
+void heapq_from_array(struct heapq_t *hq, const void *base, int n)
+{
+    heapq_reserve(hq, hq->size + n);
+    if (hq->values == NULL)
+	memcpy(hq->items + hq->size, base, (size_t)n * sizeof(void *));
+    else
+	memcpy(heapq_elem(hq, hq->size), base, (size_t)n * hq->T_size);
+    hq->size += n;
+    heapq_build(hq);
+}
+
+void heapq_from_array_key(struct heapq_t *hq, const void *base, const u64 *keys, int n)
+{
+    heapq_reserve(hq, hq->size + n);
+    memcpy(heapq_elem(hq, hq->size), base, (size_t)n * hq->T_size);
+    memcpy(hq->keys + hq->size, keys, (size_t)n * sizeof(u64));
+    hq->size += n;
+    heapq_build(hq);
+}
+
+u64 heapq_top_key(struct heapq_t *hq)
+{
+    return hq->keys[0];
 }
 
 void heapq_free(struct heapq_t *hq)
 {
-    free(hq->items);
+    heapq_array_free(hq->arity_log2, hq->items, sizeof(void *));
+    heapq_array_free(hq->arity_log2, hq->values, hq->T_size);
+    heapq_array_free(hq->arity_log2, hq->keys, sizeof(u64));
 }
 
 void heapq_init(struct heapq_t *hq, compare_fn_t *cmp)
 {
     hq->size = 0;
     hq->capacity = HEAPQ_STARTING_CAPACITY;
-    hq->items = malloc(hq->capacity * sizeof(void *));
+    hq->arity_log2 = HEAPQ_DEFAULT_ARITY_LOG2;
     hq->cmp = cmp;
+    hq->items = NULL;
+    hq->values = NULL;
+    hq->keys = NULL;
+    hq->T_size = 0;
+    heapq_alloc_arrays(hq);
 }
 
-static void heap_sort_internal(u8 *left, u8 *right, size_t size, compare_fn_t cmp)
+void heapq_init_copy(struct heapq_t *hq, u32 T_size, compare_fn_t *cmp)
 {
-    struct heapq_t heap;
-    heapq_init(&heap, cmp);
+    hq->size = 0;
+    hq->capacity = HEAPQ_STARTING_CAPACITY;
+    hq->arity_log2 = HEAPQ_DEFAULT_ARITY_LOG2;
+    hq->cmp = cmp;
+    hq->items = NULL;
+    hq->values = NULL;
+    hq->keys = NULL;
+    hq->T_size = T_size;
+    heapq_alloc_arrays(hq);
+}
 
-    u8 *p = left;
-    u8 elems[(right - left) / size][size];
-    u32 i = 0;
-    while (p <= right) {
-	memcpy(*(elems + i), p, size);
-	heapq_push(&heap, *(elems + i++));
-	p += size;
+bool heapq_set_arity(struct heapq_t *hq, u32 arity)
+{
+    if (hq->size != 0 || arity < 2 || arity > HEAPQ_MAX_ARITY || (arity & (arity - 1)) != 0)
+	return false;
+
+    heapq_free(hq);
+    hq->items = NULL;
+    hq->values = NULL;
+    hq->keys = NULL;
+    hq->arity_log2 = (u8)nicc_ctz64(arity);
+    heapq_alloc_arrays(hq);
+    return true;
+}
+
+/* indexed heapq functions */
+
+/* released handles are threaded through pos as a free list, tagged with this bit */
+#define HANDLE_FREE_BIT 0x80000000u
+
+static inline void indexed_place(struct heapq_indexed_t *hq, int idx,
+				 struct heapq_indexed_entry_t entry)
+{
+    hq->heap[idx] = entry;
+    hq->pos[entry.handle] = (u32)idx;
+}
+
+/* moves the entry at idx up into the hole above it until its parent is smaller */
+static void indexed_sift_up(struct heapq_indexed_t *hq, int idx)
+{
+    struct heapq_indexed_entry_t entry = hq->heap[idx];
+    while (idx > 0) {
+	int parent_idx = heapq_dary_parent_idx(idx, HEAPQ_DEFAULT_ARITY_LOG2);
+	if (hq->heap[parent_idx].key <= entry.key)
+	    break;
+	indexed_place(hq, idx, hq->heap[parent_idx]);
+	idx = parent_idx;
+    }
+    indexed_place(hq, idx, entry);
+}
+
+static void indexed_sift_down(struct heapq_indexed_t *hq, int idx)
+{
+    struct heapq_indexed_entry_t entry = hq->heap[idx];
+    size_t size = (size_t)hq->size;
+    size_t first;
+    while ((first = heapq_dary_first_child_idx((size_t)idx, HEAPQ_DEFAULT_ARITY_LOG2)) < size) {
+	size_t end = first + ((size_t)1 << HEAPQ_DEFAULT_ARITY_LOG2);
+	if (end > size)
+	    end = size;
+	size_t min_idx = first;
+	for (size_t c = first + 1; c < end; c++) {
+	    if (hq->heap[c].key < hq->heap[min_idx].key)
+		min_idx = c;
+	}
+
+	if (hq->heap[min_idx].key >= entry.key)
+	    break;
+	indexed_place(hq, idx, hq->heap[min_idx]);
+	idx = (int)min_idx;
     }
+    indexed_place(hq, idx, entry);
+}
 
-    p = right;
+static u32 indexed_alloc_handle(struct heapq_indexed_t *hq)
+{
+    if (hq->free_handle != HEAPQ_NO_HANDLE) {
+	u32 handle = hq->free_handle;
+	u32 next = hq->pos[handle];
+	hq->free_handle = next == HEAPQ_NO_HANDLE ? HEAPQ_NO_HANDLE : next & ~HANDLE_FREE_BIT;
+	return handle;
+    }
 
-    while (p >= left) {
-	u8 *elem = (u8 *)heapq_pop(&heap);
-	BYTE_SWAP(p, elem, size);
-	p -= size;
+    if (hq->n_handles == hq->handle_capacity) {
+	hq->handle_capacity = GROW_CAPACITY(hq->handle_capacity);
+	hq->items = GROW_ARRAY(void *, hq->items, hq->handle_capacity);
+	hq->pos = GROW_ARRAY(u32, hq->pos, hq->handle_capacity);
     }
+    return hq->n_handles++;
+}
 
-    heapq_free(&heap);
+static void indexed_release_handle(struct heapq_indexed_t *hq, u32 handle)
+{
+    /* an empty free list is HEAPQ_NO_HANDLE, which already has the free bit set */
+    hq->pos[handle] = hq->free_handle | HANDLE_FREE_BIT;
+    hq->free_handle = handle;
 }
 
-void heap_sort(const void *base, size_t nmemb, size_t size, compare_fn_t cmp)
+/* removes the entry at idx from the heap and fills the hole with the last entry */
+static void indexed_remove_at(struct heapq_indexed_t *hq, int idx)
+{
+    u32 handle = hq->heap[idx].handle;
+    if (--hq->size > idx) {
+	u64 removed_key = hq->heap[idx].key;
+	indexed_place(hq, idx, hq->heap[hq->size]);
+	if (hq->heap[idx].key < removed_key)
+	    indexed_sift_up(hq, idx);
+	else
+	    indexed_sift_down(hq, idx);
+    }
+    indexed_release_handle(hq, handle);
+}
+
+void heapq_indexed_init(struct heapq_indexed_t *hq)
+{
+    hq->size = 0;
+    hq->capacity = HEAPQ_STARTING_CAPACITY;
+    hq->heap = heapq_array_alloc(HEAPQ_DEFAULT_ARITY_LOG2, (size_t)hq->capacity,
+				 sizeof(struct heapq_indexed_entry_t));
+    hq->items = NULL;
+    hq->pos = NULL;
+    hq->n_handles = 0;
+    hq->handle_capacity = 0;
+    hq->free_handle = HEAPQ_NO_HANDLE;
+}
+
+void heapq_indexed_free(struct heapq_indexed_t *hq)
+{
+    heapq_array_free(HEAPQ_DEFAULT_ARITY_LOG2, hq->heap, sizeof(struct heapq_indexed_entry_t));
+    free(hq->items);
+    free(hq->pos);
+}
+
+u32 heapq_indexed_push(struct heapq_indexed_t *hq, void *item, u64 key)
+{
+    if (hq->size >= hq->capacity) {
+	size_t size = (size_t)hq->size;
+	hq->capacity = GROW_CAPACITY(hq->capacity);
+	hq->heap = heapq_array_grow(HEAPQ_DEFAULT_ARITY_LOG2, hq->heap, size, (size_t)hq->capacity,
+				    sizeof(struct heapq_indexed_entry_t));
+    }
+
+    u32 handle = indexed_alloc_handle(hq);
+    hq->items[handle] = item;
+    hq->heap[hq->size] = (struct heapq_indexed_entry_t){ .key = key, .handle = handle };
+    indexed_sift_up(hq, hq->size++);
+    return handle;
+}
+
+u32 heapq_indexed_top(struct heapq_indexed_t *hq)
+{
+    return hq->size > 0 ? hq->heap[0].handle : HEAPQ_NO_HANDLE;
+}
+
+void *heapq_indexed_pop(struct heapq_indexed_t *hq, u64 *key)
+{
+    if (hq->size == 0)
+	return NULL;
+
+    void *item = hq->items[hq->heap[0].handle];
+    if (key != NULL)
+	*key = hq->heap[0].key;
+    indexed_remove_at(hq, 0);
+    return item;
+}
+
+bool heapq_indexed_contains(struct heapq_indexed_t *hq, u32 handle)
 {
-    if (!nmemb)
+    return handle < hq->n_handles && !(hq->pos[handle] & HANDLE_FREE_BIT);
+}
+
+void *heapq_indexed_item(struct heapq_indexed_t *hq, u32 handle)
+{
+    return hq->items[handle];
+}
+
+u64 heapq_indexed_key(struct heapq_indexed_t *hq, u32 handle)
+{
+    return hq->heap[hq->pos[handle]].key;
+}
+
+void heapq_indexed_decrease_key(struct heapq_indexed_t *hq, u32 handle, u64 key)
+{
+    int idx = (int)hq->pos[handle];
+    hq->heap[idx].key = key;
+    indexed_sift_up(hq, idx);
+}
+
+void heapq_indexed_increase_key(struct heapq_indexed_t *hq, u32 handle, u64 key)
+{
+    int idx = (int)hq->pos[handle];
+    hq->heap[idx].key = key;
+    indexed_sift_down(hq, idx);
+}
+
+void *heapq_indexed_remove(struct heapq_indexed_t *hq, u32 handle)
+{
+    void *item = hq->items[handle];
+    indexed_remove_at(hq, (int)hq->pos[handle]);
+    return item;
+}
+
+/*
+ * in-place bottom-up heapsort.
+ * the sift walks from the root of the subheap down to a leaf along the path of
+ * the child that belongs on top, without comparing against the sifted element,
+ * then climbs back up to where the element fits. that is about half the
+ * comparisons of the classic sift, as most elements end up near the leaves.
+ * desc builds a min-heap, which leaves the array in descending order.
+ */
+#define HEAPSORT_BEFORE(a, b) (desc ? cmp((b), (a)) > 0 : cmp((a), (b)) > 0)
+
+/* sort 4 and 8 byte elements holding the sifted element in a register */
+#define DEFINE_HEAPSORT(T, suffix)                                                  \
+    static void heapsort_sift_##suffix(T *a, size_t n, size_t i, compare_fn_t *cmp, \
+				       bool desc)                                   \
+    {                                                                               \
+	size_t j = i;                                                               \
+	size_t c;                                                                   \
+	while ((c = 2 * j + 1) + 1 < n)                                             \
+	    j = HEAPSORT_BEFORE(&a[c + 1], &a[c]) ? c + 1 : c;                      \
+	if (c < n)                                                                  \
+	    j = c;                                                                  \
+	while (HEAPSORT_BEFORE(&a[i], &a[j]))                                       \
+	    j = (j - 1) / 2;                                                        \
+	T x = a[j];                                                                 \
+	a[j] = a[i];                                                                \
+	while (j > i) {                                                             \
+	    j = (j - 1) / 2;                                                        \
+	    T tmp = a[j];                                                           \
+	    a[j] = x;                                                               \
+	    x = tmp;                                                                \
+	}                                                                           \
+    }                                                                               \
+                                                                                    \
+    static void heapsort_##suffix(T *a, size_t n, compare_fn_t *cmp, bool desc)     \
+    {                                                                               \
+	for (size_t i = n / 2; i-- > 0;)                                            \
+	    heapsort_sift_##suffix(a, n, i, cmp, desc);                             \
+	for (size_t end = n - 1; end > 0; end--) {                                  \
+	    T tmp = a[0];                                                           \
+	    a[0] = a[end];                                                          \
+	    a[end] = tmp;                                                           \
+	    heapsort_sift_##suffix(a, end, 0, cmp, desc);                           \
+	}                                                                           \
+    }
+
+DEFINE_HEAPSORT(u32, u32)
+DEFINE_HEAPSORT(u64, u64)
+
+static void heapsort_sift_bytes(u8 *a, size_t n, size_t size, size_t i, compare_fn_t *cmp,
+				bool desc)
+{
+    size_t j = i;
+    size_t c;
+    while ((c = 2 * j + 1) + 1 < n)
+	j = HEAPSORT_BEFORE(a + (c + 1) * size, a + c * size) ? c + 1 : c;
+    if (c < n)
+	j = c;
+    while (HEAPSORT_BEFORE(a + i * size, a + j * size))
+	j = (j - 1) / 2;
+
+    /*
+     * rotate the element at i down to j and the path between them up one level,
+     * using slot i as the temporary so no element sized buffer is needed
+     */
+    if (j == i)
 	return;
+    nicc_data_swap(a + i * size, a + j * size, size);
+    while ((j = (j - 1) / 2) > i)
+	nicc_data_swap(a + i * size, a + j * size, size);
+}
 
-    u8 *base_ptr = (u8 *)base;
-    u8 *left_ptr = base_ptr;
-    u8 *right_ptr = base_ptr + size * (nmemb - 1);
-    heap_sort_internal(left_ptr, right_ptr, size, cmp);
+static void heapsort_bytes(u8 *a, size_t n, size_t size, compare_fn_t *cmp, bool desc)
+{
+    for (size_t i = n / 2; i-- > 0;)
+	heapsort_sift_bytes(a, n, size, i, cmp, desc);
+    for (size_t end = n - 1; end > 0; end--) {
+	nicc_data_swap(a, a + end * size, size);
+	heapsort_sift_bytes(a, end, size, 0, cmp, desc);
+    }
+}
+
+static void heapsort_dispatch(void *base, size_t nmemb, size_t size, compare_fn_t *cmp, bool desc)
+{
+    if (nmemb < 2)
+	return;
+
+    if (size == sizeof(u32) && (uintptr_t)base % _Alignof(u32) == 0)
+	heapsort_u32(base, nmemb, cmp, desc);
+    else if (size == sizeof(u64) && (uintptr_t)base % _Alignof(u64) == 0)
+	heapsort_u64(base, nmemb, cmp, desc);
+    else
+	heapsort_bytes(base, nmemb, size, cmp, desc);
+}
+
+void heap_sort(const void *base, size_t nmemb, size_t size, compare_fn_t cmp)
+{
+    heapsort_dispatch((void *)base, nmemb, size, cmp, true);
+}
+
+void heap_sort_ascending(void *base, size_t nmemb, size_t size, compare_fn_t *cmp)
+{
+    heapsort_dispatch(base, nmemb, size, cmp, false);
+}
+
+/*
+ * sift for a binary heap laid out directly in an array. the root is the largest
+ * element if max_heap, otherwise the smallest.
+ */
+static void sift_down_array(u8 *base, size_t nmemb, size_t size, size_t idx, compare_fn_t *cmp,
+			    bool max_heap)
+{
+    for (;;) {
+	size_t child = 2 * idx + 1;
+	if (child >= nmemb)
+	    break;
+
+	u8 *a = base + child * size;
+	u8 *b = a + size;
+	if (child + 1 < nmemb && (max_heap ? cmp(a, b) : cmp(b, a)) < 0)
+	    child++;
+
+	u8 *parent = base + idx * size;
+	u8 *c = base + child * size;
+	if ((max_heap ? cmp(parent, c) : cmp(c, parent)) >= 0)
+	    break;
+	nicc_data_swap(parent, c, size);
+	idx = child;
+    }
+}
+
+static size_t heap_select(const void *base, size_t nmemb, size_t size, size_t n, compare_fn_t *cmp,
+			  void *out, bool largest)
+{
+    size_t k = n < nmemb ? n : nmemb;
+    if (k == 0)
+	return 0;
+
+    /*
+     * out holds the best k elements seen so far as a heap with the worst of them
+     * at the root, so every other element only needs one comparison against it
+     */
+    bool max_heap = !largest;
+    u8 *heap = out;
+    memcpy(heap, base, k * size);
+    for (size_t i = k / 2; i-- > 0;)
+	sift_down_array(heap, k, size, i, cmp, max_heap);
+
+    for (size_t i = k; i < nmemb; i++) {
+	const u8 *elem = (const u8 *)base + i * size;
+	i32 c = cmp(elem, heap);
+	if (largest ? c > 0 : c < 0) {
+	    memcpy(heap, elem, size);
+	    sift_down_array(heap, k, size, 0, cmp, max_heap);
+	}
+    }
+
+    /* moving the root to the back leaves the best element first */
+    for (size_t end = k; end-- > 1;) {
+	nicc_data_swap(heap, heap + end * size, size);
+	sift_down_array(heap, end, size, 0, cmp, max_heap);
+    }
+    return k;
+}
+
+size_t heap_nsmallest(const void *base, size_t nmemb, size_t size, size_t n, compare_fn_t *cmp,
+		      void *out)
+{
+    return heap_select(base, nmemb, size, n, cmp, out, false);
+}
+
+size_t heap_nlargest(const void *base, size_t nmemb, size_t size, size_t n, compare_fn_t *cmp,
+		     void *out)
+{
+    return heap_select(base, nmemb, size, n, cmp, out, true);
 }
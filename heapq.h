@@ -21,7 +21,10 @@
 #include <stdbool.h>
 
 #define HEAPQ_STARTING_CAPACITY 32
+#define HEAPQ_DEFAULT_ARITY_LOG2 2 // 4-ary
+#define HEAPQ_MAX_ARITY 16
 
+/* index math for a binary heap, arity 2 */
 #define heapq_left_child_idx(parent_idx) ((parent_idx << 1) + 1)
 #define heapq_right_child_idx(parent_idx) ((parent_idx + 1) << 1)
 #define heapq_parent_idx(child_idx) ((child_idx - 1) >> 1)
@@ -29,18 +32,55 @@
 #define heapq_has_left(idx, size) (heapq_left_child_idx(idx) < size)
 #define heapq_has_right(idx, size) (heapq_right_child_idx(idx) < size)
 
-/* heap queue inspired by: https://docs.python.org/3/library/heapq.html */
+/* index math for a heap where every node has 2^log2_arity children, like a heapq_t */
+static inline size_t heapq_dary_first_child_idx(size_t parent_idx, u8 log2_arity)
+{
+    return (parent_idx << log2_arity) + 1;
+}
+
+static inline int heapq_dary_parent_idx(int child_idx, u8 log2_arity)
+{
+    return (child_idx - 1) >> log2_arity;
+}
+
+/*
+ * heap queue inspired by: https://docs.python.org/3/library/heapq.html
+ *
+ * A heapq either stores pointers to items owned by the caller (heapq_init), or
+ * copies of the items by value in one contiguous buffer (heapq_init_copy). A
+ * copy heapq without a cmp function orders its items by a u64 key given on push
+ * instead, so comparisons never leave the keys array.
+ *
+ * The heap is 4-ary by default, which halves the depth of a binary heap while the
+ * four children still fit in one cache line. See heapq_set_arity().
+ */
 struct heapq_t {
-    void **items;
+    void **items; // pointer heapq only
     int size;
     int capacity;
     compare_fn_t *cmp;
+    u8 *values; // copy heapq only, capacity elements of T_size bytes
+    u64 *keys; // keyed copy heapq only, key of the element at the same index
+    u32 T_size;
+    u8 arity_log2;
 };
 
-/* heapq functions */
+/*
+ * heapq functions.
+ * push, pop, pushpop and replace take and return item pointers, so they only work
+ * on a pointer heapq. on a copy heapq push returns false and the others NULL, use
+ * the _copy functions instead.
+ */
 void heapq_init(struct heapq_t *hq, compare_fn_t *cmp);
 void heapq_free(struct heapq_t *hq);
-void heapq_push(struct heapq_t *hq, void *item);
+/*
+ * changes the number of children per node, which must be a power of two between
+ * 2 and HEAPQ_MAX_ARITY. returns false if the arity is not supported or the
+ * heapq is not empty.
+ */
+bool heapq_set_arity(struct heapq_t *hq, u32 arity);
+bool heapq_push(struct heapq_t *hq, void *item);
+/* returns the item at idx. for a copy heapq this points into the heapq itself */
 void *heapq_get(struct heapq_t *hq, int idx);
 
 /*
@@ -50,6 +90,116 @@ void *heapq_get(struct heapq_t *hq, int idx);
  */
 void *heapq_pop(struct heapq_t *hq);
 
+/*
+ * pushes item and then pops the top in a single sift, returning item itself if
+ * it would be the new top.
+ */
+void *heapq_pushpop(struct heapq_t *hq, void *item);
+/*
+ * pops the top and then pushes item in a single sift. returns the old top, or
+ * NULL if the heapq was empty.
+ */
+void *heapq_replace(struct heapq_t *hq, void *item);
+
+/*
+ * adds n items from base to the heapq and restores the heap order in
+ * O(size + n) with Floyd's method, which beats n pushes at O(n log n).
+ * base is an array of n item pointers for a pointer heapq, or of n elements for
+ * a copy heapq. keyed heapqs use heapq_from_array_key().
+ */
+void heapq_from_array(struct heapq_t *hq, const void *base, int n);
+
+/*
+ * copy heapq functions.
+ * if cmp is NULL the heapq is keyed and items must be pushed with
+ * heapq_push_copy_key(), the smallest key is popped first.
+ */
+void heapq_init_copy(struct heapq_t *hq, u32 T_size, compare_fn_t *cmp);
+void heapq_push_copy(struct heapq_t *hq, const void *item);
+void heapq_push_copy_key(struct heapq_t *hq, const void *item, u64 key);
+/*
+ * copies the item at the top of the heapq into return_ptr, unless it is NULL,
+ * and removes it. returns false if the heapq is empty.
+ */
+bool heapq_pop_copy(struct heapq_t *hq, void *return_ptr);
+/* key of the item at the top of a non-empty keyed heapq */
+u64 heapq_top_key(struct heapq_t *hq);
+/*
+ * copy versions of heapq_pushpop() and heapq_replace(). return_ptr gets the
+ * popped item, unless it is NULL.
+ */
+void heapq_pushpop_copy(struct heapq_t *hq, const void *item, void *return_ptr);
+void heapq_pushpop_copy_key(struct heapq_t *hq, const void *item, u64 key, void *return_ptr);
+/* returns false, and leaves return_ptr untouched, if the heapq was empty */
+bool heapq_replace_copy(struct heapq_t *hq, const void *item, void *return_ptr);
+bool heapq_replace_copy_key(struct heapq_t *hq, const void *item, u64 key, void *return_ptr);
+void heapq_from_array_key(struct heapq_t *hq, const void *base, const u64 *keys, int n);
+
+#define HEAPQ_NO_HANDLE UINT32_MAX
+
+struct heapq_indexed_entry_t {
+    u64 key;
+    u32 handle;
+};
+
+/*
+ * Indexed heap queue ordered by u64 keys.
+ * Every push returns a handle that refers to the item for as long as it is in
+ * the heap. A position map from handle to heap index is kept up to date on every
+ * move, so the key of an item can be changed, or the item removed, in O(log n)
+ * instead of pushing duplicates and skipping stale pops.
+ * Handles of popped or removed items are reused by later pushes.
+ */
+struct heapq_indexed_t {
+    struct heapq_indexed_entry_t *heap; // 4-ary heap, laid out like heapq_t
+    int size;
+    int capacity;
+    void **items; // item of each handle
+    u32 *pos; // heap index of each handle, or the free list link of a released handle
+    u32 n_handles; // handles handed out so far
+    u32 handle_capacity;
+    u32 free_handle; // most recently released handle, HEAPQ_NO_HANDLE if none
+};
+
+void heapq_indexed_init(struct heapq_indexed_t *hq);
+void heapq_indexed_free(struct heapq_indexed_t *hq);
+u32 heapq_indexed_push(struct heapq_indexed_t *hq, void *item, u64 key);
+/* handle of the item with the smallest key, HEAPQ_NO_HANDLE if the heapq is empty */
+u32 heapq_indexed_top(struct heapq_indexed_t *hq);
+/*
+ * returns and removes the item with the smallest key, storing the key in key
+ * unless it is NULL. returns NULL if the heapq is empty.
+ */
+void *heapq_indexed_pop(struct heapq_indexed_t *hq, u64 *key);
+/* true if handle refers to an item that is still in the heapq */
+bool heapq_indexed_contains(struct heapq_indexed_t *hq, u32 handle);
+void *heapq_indexed_item(struct heapq_indexed_t *hq, u32 handle);
+u64 heapq_indexed_key(struct heapq_indexed_t *hq, u32 handle);
+/*
+ * change the key of an item in the heapq. the new key must not be larger
+ * (smaller) than the current key of the item.
+ */
+void heapq_indexed_decrease_key(struct heapq_indexed_t *hq, u32 handle, u64 key);
+void heapq_indexed_increase_key(struct heapq_indexed_t *hq, u32 handle, u64 key);
+/* removes the item from the heapq and returns it */
+void *heapq_indexed_remove(struct heapq_indexed_t *hq, u32 handle);
+
+/*
+ * sorts base in place into descending order, the reverse of the order a heapq
+ * pops in. O(n log n) time and O(1) extra memory.
+ */
 void heap_sort(const void *base, size_t nmemb, size_t size, compare_fn_t *cmp);
+/* same as heap_sort() but into ascending order, like qsort() */
+void heap_sort_ascending(void *base, size_t nmemb, size_t size, compare_fn_t *cmp);
+
+/*
+ * writes the n smallest (largest) elements of base to out, sorted from the
+ * smallest (largest). out must have room for n elements. runs in O(nmemb log n)
+ * without allocating. returns the number of elements written, min(n, nmemb).
+ */
+size_t heap_nsmallest(const void *base, size_t nmemb, size_t size, size_t n, compare_fn_t *cmp,
+		      void *out);
+size_t heap_nlargest(const void *base, size_t nmemb, size_t size, size_t n, compare_fn_t *cmp,
+		     void *out);
 
 #endif /* NICC_HEAPQ_H */
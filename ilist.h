@@ -0,0 +1,164 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef NICC_ILIST_H
+#define NICC_ILIST_H
+
+#include <stdbool.h>
+
+#include "common.h"
+
+#ifdef NICC_TYPEDEF
+typedef struct ilist_t IList;
+typedef struct ilist_node_t IListNode;
+#endif /* NICC_TYPEDEF */
+
+/*
+ * Intrusive circular doubly linked list, like the list_head of the Linux kernel.
+ * The node is embedded in the user struct and the struct is recovered from a
+ * node with NICC_CONTAINER_OF(), so no operation allocates. A struct can be
+ * in several lists at once by embedding one node per list.
+ *
+ * struct job { int id; struct ilist_node_t node; };
+ * struct job *j = NICC_CONTAINER_OF(ilist_first(&list), struct job, node);
+ *
+ * All operations are O(1) and live in this header so they can be inlined.
+ */
+struct ilist_node_t {
+    struct ilist_node_t *prev;
+    struct ilist_node_t *next;
+};
+
+/* the head is a sentinel node, an empty list points at itself */
+struct ilist_t {
+    struct ilist_node_t head;
+};
+
+static inline void ilist_init(struct ilist_t *list)
+{
+    list->head.prev = &list->head;
+    list->head.next = &list->head;
+}
+
+/* an initialized node that is in no list, so ilist_unlink() on it is a no-op */
+static inline void ilist_node_init(struct ilist_node_t *node)
+{
+    node->prev = node;
+    node->next = node;
+}
+
+static inline bool ilist_empty(struct ilist_t *list)
+{
+    return list->head.next == &list->head;
+}
+
+static inline bool ilist_node_linked(struct ilist_node_t *node)
+{
+    return node->next != node;
+}
+
+/* NULL if the list is empty */
+static inline struct ilist_node_t *ilist_first(struct ilist_t *list)
+{
+    return ilist_empty(list) ? NULL : list->head.next;
+}
+
+static inline struct ilist_node_t *ilist_last(struct ilist_t *list)
+{
+    return ilist_empty(list) ? NULL : list->head.prev;
+}
+
+static inline void ilist_insert_after(struct ilist_node_t *pos, struct ilist_node_t *node)
+{
+    node->prev = pos;
+    node->next = pos->next;
+    pos->next->prev = node;
+    pos->next = node;
+}
+
+static inline void ilist_insert_before(struct ilist_node_t *pos, struct ilist_node_t *node)
+{
+    ilist_insert_after(pos->prev, node);
+}
+
+static inline void ilist_push_front(struct ilist_t *list, struct ilist_node_t *node)
+{
+    ilist_insert_after(&list->head, node);
+}
+
+static inline void ilist_push_back(struct ilist_t *list, struct ilist_node_t *node)
+{
+    ilist_insert_before(&list->head, node);
+}
+
+static inline void ilist_unlink(struct ilist_node_t *node)
+{
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    ilist_node_init(node);
+}
+
+/* unlinks and returns the first node, NULL if the list is empty */
+static inline struct ilist_node_t *ilist_pop_front(struct ilist_t *list)
+{
+    struct ilist_node_t *node = ilist_first(list);
+    if (node != NULL)
+	ilist_unlink(node);
+    return node;
+}
+
+static inline void ilist_move_to_front(struct ilist_t *list, struct ilist_node_t *node)
+{
+    ilist_unlink(node);
+    ilist_push_front(list, node);
+}
+
+static inline void ilist_move_to_back(struct ilist_t *list, struct ilist_node_t *node)
+{
+    ilist_unlink(node);
+    ilist_push_back(list, node);
+}
+
+/* moves every node of src in front of pos, leaving src empty */
+static inline void ilist_splice(struct ilist_node_t *pos, struct ilist_t *src)
+{
+    if (ilist_empty(src))
+	return;
+
+    struct ilist_node_t *first = src->head.next;
+    struct ilist_node_t *last = src->head.prev;
+    first->prev = pos->prev;
+    pos->prev->next = first;
+    last->next = pos;
+    pos->prev = last;
+    ilist_init(src);
+}
+
+/* appends every node of src to dst, leaving src empty */
+static inline void ilist_splice_back(struct ilist_t *dst, struct ilist_t *src)
+{
+    ilist_splice(&dst->head, src);
+}
+
+/* node is a struct ilist_node_t *. the _SAFE variant allows unlinking node */
+#define NICC_ILIST_FOR_EACH(list, node) \
+    for (node = (list)->head.next; node != &(list)->head; node = node->next)
+
+#define NICC_ILIST_FOR_EACH_SAFE(list, node, tmp)                           \
+    for (node = (list)->head.next, tmp = node->next; node != &(list)->head; \
+	 node = tmp, tmp = node->next)
+
+#endif /* NICC_ILIST_H */
@@ -28,23 +28,50 @@ void linkedlist_init(struct linkedlist_t *ll, u32 T_size)
     ll->head = NULL;
     ll->tail = NULL;
     ll->T_size = T_size;
+    ll->pool = NULL;
+    linkedlist_pool_init(&ll->own_pool);
+}
+
+void linkedlist_init_shared(struct linkedlist_t *ll, u32 T_size, struct slab_t *pool)
+{
+    linkedlist_init(ll, T_size);
+    ll->pool = pool;
+}
+
+void linkedlist_pool_init(struct slab_t *pool)
+{
+    slab_init(pool, sizeof(struct linkedlist_item_t));
+}
+
+static inline struct slab_t *item_pool(struct linkedlist_t *ll)
+{
+    return ll->pool != NULL ? ll->pool : &ll->own_pool;
 }
 
 void linkedlist_free(struct linkedlist_t *ll)
 {
-    struct linkedlist_item_t *next = ll->head;
-    while (next != NULL) {
-        struct linkedlist_item_t *this = next;
-        next = next->next;
-        free(this);
+    if (ll->pool == NULL) {
+        /* every item lives in the chunks of own_pool */
+        slab_free(&ll->own_pool);
+    } else {
+        struct linkedlist_item_t *next = ll->head;
+        while (next != NULL) {
+            struct linkedlist_item_t *this = next;
+            next = next->next;
+            slab_release(ll->pool, this);
+        }
     }
+
+    ll->size = 0;
+    ll->head = NULL;
+    ll->tail = NULL;
 }
 
 void linkedlist_append(struct linkedlist_t *ll, void *data)
 {
     ll->size++;
 
-    struct linkedlist_item_t *item = malloc(sizeof(struct linkedlist_item_t));
+    struct linkedlist_item_t *item = slab_alloc(item_pool(ll));
     item->data = data;
     item->prev = NULL;
     item->next = NULL;
@@ -82,7 +109,7 @@ void linkedlist_remove_item(struct linkedlist_t *ll, struct linkedlist_item_t *t
         ll->tail = prev_item;
     }
 
-    free(to_remove);
+    slab_release(item_pool(ll), to_remove);
 }
 
 bool linkedlist_remove_idx(struct linkedlist_t *ll, size_t idx)
@@ -115,6 +142,147 @@ bool linkedlist_remove(struct linkedlist_t *ll, void *data)
     return false;
 }
 
+/*
+ * merges two sorted chains that are linked through next only. a goes first on
+ * ties, which keeps the sort stable.
+ */
+static struct linkedlist_item_t *merge_chains(struct linkedlist_item_t *a,
+                                              struct linkedlist_item_t *b, compare_fn_t *cmp)
+{
+    struct linkedlist_item_t head;
+    struct linkedlist_item_t *tail = &head;
+    while (a != NULL && b != NULL) {
+        if (cmp(b->data, a->data) < 0) {
+            tail->next = b;
+            b = b->next;
+        } else {
+            tail->next = a;
+            a = a->next;
+        }
+        tail = tail->next;
+    }
+    tail->next = a != NULL ? a : b;
+    return head.next;
+}
+
+/* restores the prev links, head and tail after the items were relinked through next */
+static void relink(struct linkedlist_t *ll, struct linkedlist_item_t *first)
+{
+    struct linkedlist_item_t *prev = NULL;
+    for (struct linkedlist_item_t *item = first; item != NULL; item = item->next) {
+        item->prev = prev;
+        prev = item;
+    }
+    ll->head = first;
+    ll->tail = prev;
+}
+
+void linkedlist_sort(struct linkedlist_t *ll, compare_fn_t *cmp)
+{
+    /*
+     * runs[i] is either empty or a sorted run of 2^i items that all come before
+     * the items not yet visited. every item is merged into the runs like a carry
+     * propagating through a binary counter.
+     */
+    struct linkedlist_item_t *runs[64] = { NULL };
+    struct linkedlist_item_t *item = ll->head;
+    while (item != NULL) {
+        struct linkedlist_item_t *next = item->next;
+        item->next = NULL;
+
+        struct linkedlist_item_t *run = item;
+        size_t i = 0;
+        for (; runs[i] != NULL; i++) {
+            run = merge_chains(runs[i], run, cmp);
+            runs[i] = NULL;
+        }
+        runs[i] = run;
+        item = next;
+    }
+
+    struct linkedlist_item_t *sorted = NULL;
+    for (size_t i = 0; i < 64; i++) {
+        if (runs[i] != NULL)
+            sorted = merge_chains(runs[i], sorted, cmp);
+    }
+    relink(ll, sorted);
+}
+
+/*
+ * makes the items of other belong to the pool of ll and detaches them from
+ * other. the returned chain keeps its prev and next links, last is set to its
+ * final item.
+ */
+static struct linkedlist_item_t *take_items(struct linkedlist_t *ll, struct linkedlist_t *other,
+                                            struct linkedlist_item_t **last)
+{
+    struct linkedlist_item_t *first = other->head;
+    *last = other->tail;
+    if (other->pool == NULL) {
+        slab_adopt(item_pool(ll), &other->own_pool);
+    } else if (other->pool != ll->pool) {
+        /* items of a foreign shared pool can not change owner, copy them over */
+        struct linkedlist_item_t *prev = NULL;
+        struct linkedlist_item_t *item = other->head;
+        while (item != NULL) {
+            struct linkedlist_item_t *copy = slab_alloc(item_pool(ll));
+            copy->data = item->data;
+            copy->prev = prev;
+            copy->next = NULL;
+            if (prev != NULL)
+                prev->next = copy;
+            else
+                first = copy;
+            prev = copy;
+
+            struct linkedlist_item_t *next = item->next;
+            slab_release(other->pool, item);
+            item = next;
+        }
+        *last = prev;
+    }
+
+    ll->size += other->size;
+    other->head = NULL;
+    other->tail = NULL;
+    other->size = 0;
+    return first;
+}
+
+void linkedlist_splice(struct linkedlist_t *ll, struct linkedlist_item_t *pos,
+                       struct linkedlist_t *other)
+{
+    if (other->head == NULL)
+        return;
+
+    struct linkedlist_item_t *last;
+    struct linkedlist_item_t *first = take_items(ll, other, &last);
+    struct linkedlist_item_t *before = pos != NULL ? pos->prev : ll->tail;
+
+    first->prev = before;
+    if (before != NULL)
+        before->next = first;
+    else
+        ll->head = first;
+
+    last->next = pos;
+    if (pos != NULL)
+        pos->prev = last;
+    else
+        ll->tail = last;
+}
+
+void linkedlist_merge_sorted(struct linkedlist_t *ll, struct linkedlist_t *other,
+                             compare_fn_t *cmp)
+{
+    if (other->head == NULL)
+        return;
+
+    struct linkedlist_item_t *last;
+    struct linkedlist_item_t *first = take_items(ll, other, &last);
+    relink(ll, merge_chains(ll->head, first, cmp));
+}
+
 void linkedlist_print(struct linkedlist_t *ll)
 {
     for (struct linkedlist_item_t *item = ll->head; item != NULL; item = item->next) {
@@ -25,6 +25,7 @@ typedef struct linkedlist_item_t LinkedListItem;
 #include <stdlib.h>
 #include <stdbool.h>
 #include "common.h"
+#include "slab.h"
 
 
 struct linkedlist_item_t {
@@ -42,17 +43,29 @@ struct linkedlist_t {
     struct linkedlist_item_t *tail;
     size_t size; // for convenience
     u32 T_size; // sizeof the value that data in linkedlist_item_t points to
+    struct slab_t *pool; // shared node pool, NULL if the nodes come from own_pool
+    struct slab_t own_pool;
 };
 
 /* functions */
 
 /*
- * Same as `struct linkedlist_t ll = { .head = NULL, .tail = NULL, . size = 0, .T_size = T_size }`
+ * Initializes an empty linkedlist that allocates its items from its own pool.
  */
 void linkedlist_init(struct linkedlist_t *ll, u32 T_size);
 
+/*
+ * Initializes an empty linkedlist that allocates its items from pool, which may
+ * be shared by several linkedlists. The pool must be initialized with
+ * linkedlist_pool_init() and outlive the linkedlist.
+ */
+void linkedlist_init_shared(struct linkedlist_t *ll, u32 T_size, struct slab_t *pool);
+void linkedlist_pool_init(struct slab_t *pool);
+
 /*
  * Frees all the connected items in the linkedlist.
+ * A linkedlist with its own pool releases the pool chunks without visiting the
+ * items, a linkedlist on a shared pool returns every item to the pool.
  */
 void linkedlist_free(struct linkedlist_t *ll);
 
@@ -76,6 +89,30 @@ bool linkedlist_remove(struct linkedlist_t *ll, void *data);
  */
 bool linkedlist_remove_idx(struct linkedlist_t *ll, size_t idx);
 
+/*
+ * Sorts the linkedlist by the data of each item using a stable bottom-up merge
+ * sort. Existing items are relinked, nothing is allocated or copied.
+ */
+void linkedlist_sort(struct linkedlist_t *ll, compare_fn_t *cmp);
+
+/*
+ * Moves every item of other into ll right before pos, or to the end of ll if pos
+ * is NULL. other is left empty.
+ * O(1) when both linkedlists use the same shared pool, or when other has its own
+ * pool, whose chunks are handed over to the pool of ll. When other uses a
+ * different shared pool its items are reallocated from the pool of ll, O(n).
+ */
+void linkedlist_splice(struct linkedlist_t *ll, struct linkedlist_item_t *pos,
+                       struct linkedlist_t *other);
+
+/*
+ * Merges other into ll, both of which must be sorted by cmp, so that ll stays
+ * sorted. Equal items from ll come before those from other. other is left empty.
+ * Items change pool the same way as in linkedlist_splice().
+ */
+void linkedlist_merge_sorted(struct linkedlist_t *ll, struct linkedlist_t *other,
+                             compare_fn_t *cmp);
+
 /*
  * Prints the data pointers of every item.
  */
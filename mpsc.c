@@ -0,0 +1,82 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "common.h"
+#include "mpsc.h"
+
+void mpsc_init(struct mpsc_queue_t *q)
+{
+    atomic_init(&q->stub.next, NULL);
+    atomic_init(&q->head, &q->stub);
+    q->tail = &q->stub;
+}
+
+void mpsc_push(struct mpsc_queue_t *q, struct mpsc_node_t *node)
+{
+    atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+    /* serializes the producers, prev is only ever linked by this producer */
+    struct mpsc_node_t *prev = atomic_exchange_explicit(&q->head, node, memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, node, memory_order_release);
+}
+
+struct mpsc_node_t *mpsc_pop(struct mpsc_queue_t *q)
+{
+    struct mpsc_node_t *tail = q->tail;
+    struct mpsc_node_t *next = atomic_load_explicit(&tail->next, memory_order_acquire);
+
+    /* skip over the stub */
+    if (tail == &q->stub) {
+	if (next == NULL)
+	    return NULL;
+	q->tail = next;
+	tail = next;
+	next = atomic_load_explicit(&next->next, memory_order_acquire);
+    }
+
+    if (next != NULL) {
+	q->tail = next;
+	return tail;
+    }
+
+    /* a producer has swapped head but not yet linked its node */
+    struct mpsc_node_t *head = atomic_load_explicit(&q->head, memory_order_acquire);
+    if (tail != head)
+	return NULL;
+
+    /* tail is the last node, push the stub behind it so tail can be handed out */
+    mpsc_push(q, &q->stub);
+    next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (next != NULL) {
+	q->tail = next;
+	return tail;
+    }
+
+    return NULL;
+}
+
+size_t mpsc_drain(struct mpsc_queue_t *q, mpsc_drain_fn_t *fn, void *ctx, size_t max)
+{
+    size_t popped = 0;
+    struct mpsc_node_t *node;
+    while ((max == 0 || popped < max) && (node = mpsc_pop(q)) != NULL) {
+	fn(node, ctx);
+	popped++;
+    }
+    return popped;
+}
@@ -0,0 +1,72 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef NICC_MPSC_H
+#define NICC_MPSC_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common.h"
+
+#ifdef NICC_TYPEDEF
+typedef struct mpsc_queue_t MPSCQueue;
+typedef struct mpsc_node_t MPSCNode;
+#endif /* NICC_TYPEDEF */
+
+/*
+ * Intrusive link, embedded in the struct that is queued and recovered with
+ * NICC_CONTAINER_OF(). Like linkedlist_item_t, but only the next link is kept.
+ */
+struct mpsc_node_t {
+    _Atomic(struct mpsc_node_t *) next;
+};
+
+/*
+ * Multi producer single consumer queue (Dmitry Vyukov's intrusive MPSC queue).
+ * Any amount of threads may push concurrently, and pushing is wait-free: one
+ * atomic exchange and one store. Only one thread may pop. Nothing is allocated.
+ *
+ * A producer that was preempted between its exchange and its store leaves
+ * the queue briefly cut off after its node. mpsc_pop() returns NULL in that
+ * window even though later nodes were pushed, so consumers should treat
+ * NULL as "nothing available right now" rather than as "empty forever".
+ */
+struct mpsc_queue_t {
+    _Atomic(struct mpsc_node_t *) head; // most recently pushed node
+    char pad[64 - sizeof(void *)]; // keeps the producers' and consumer's ends on separate lines
+    struct mpsc_node_t *tail; // next node to pop, only touched by the consumer
+    struct mpsc_node_t stub;
+};
+
+typedef void mpsc_drain_fn_t(struct mpsc_node_t *node, void *ctx);
+
+void mpsc_init(struct mpsc_queue_t *q);
+
+/* safe to call from any thread */
+void mpsc_push(struct mpsc_queue_t *q, struct mpsc_node_t *node);
+
+/* consumer only. NULL if nothing can be popped right now */
+struct mpsc_node_t *mpsc_pop(struct mpsc_queue_t *q);
+
+/*
+ * Consumer only. Pops up to max nodes, or every available node if max is 0,
+ * calling fn on each of them. Returns the amount of nodes popped.
+ */
+size_t mpsc_drain(struct mpsc_queue_t *q, mpsc_drain_fn_t *fn, void *ctx, size_t max);
+
+#endif /* NICC_MPSC_H */
@@ -0,0 +1,117 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "common.h"
+#include "radixheap.h"
+
+static inline u32 bucket_idx(u64 key, u64 last)
+{
+    return key == last ? 0 : 64 - nicc_clz64(key ^ last);
+}
+
+static inline void bucket_append(struct radixheap_t *h, u32 b, u64 key, void *item)
+{
+    struct radixheap_bucket_t *bucket = &h->buckets[b];
+    if (bucket->size >= bucket->capacity) {
+	bucket->capacity = GROW_CAPACITY(bucket->capacity);
+	bucket->entries =
+	    GROW_ARRAY(struct radixheap_entry_t, bucket->entries, bucket->capacity);
+    }
+    bucket->entries[bucket->size++] = (struct radixheap_entry_t){ key, item };
+    if (b != 0)
+	h->occupied |= (u64)1 << (b - 1);
+}
+
+/*
+ * refills bucket 0 when it is empty by making the smallest key of the lowest
+ * non-empty bucket the new last key. every other key in that bucket shares the
+ * bits above the differing bit with it, so they all land in lower buckets.
+ */
+static void redistribute(struct radixheap_t *h)
+{
+    if (h->buckets[0].size != 0)
+	return;
+
+    u32 b = nicc_ctz64(h->occupied) + 1;
+    struct radixheap_bucket_t *bucket = &h->buckets[b];
+    u64 min = bucket->entries[0].key;
+    for (u32 i = 1; i < bucket->size; i++) {
+	if (bucket->entries[i].key < min)
+	    min = bucket->entries[i].key;
+    }
+
+    h->last = min;
+    h->occupied &= ~((u64)1 << (b - 1));
+    u32 n = bucket->size;
+    bucket->size = 0;
+    for (u32 i = 0; i < n; i++) {
+	struct radixheap_entry_t *e = &bucket->entries[i];
+	bucket_append(h, bucket_idx(e->key, min), e->key, e->item);
+    }
+}
+
+bool radixheap_push(struct radixheap_t *h, void *item, u64 key)
+{
+    if (key < h->last)
+	return false;
+
+    bucket_append(h, bucket_idx(key, h->last), key, item);
+    h->size++;
+    return true;
+}
+
+void *radixheap_pop(struct radixheap_t *h, u64 *key)
+{
+    if (h->size == 0)
+	return NULL;
+
+    redistribute(h);
+    struct radixheap_bucket_t *bucket = &h->buckets[0];
+    h->size--;
+    if (key != NULL)
+	*key = h->last;
+    return bucket->entries[--bucket->size].item;
+}
+
+u64 radixheap_top_key(struct radixheap_t *h)
+{
+    if (h->size == 0)
+	return UINT64_MAX;
+
+    redistribute(h);
+    return h->last;
+}
+
+void radixheap_init(struct radixheap_t *h)
+{
+    h->last = 0;
+    h->size = 0;
+    h->occupied = 0;
+    for (u32 b = 0; b < RADIXHEAP_BUCKETS; b++) {
+	h->buckets[b].entries = NULL;
+	h->buckets[b].size = 0;
+	h->buckets[b].capacity = 0;
+    }
+}
+
+void radixheap_free(struct radixheap_t *h)
+{
+    for (u32 b = 0; b < RADIXHEAP_BUCKETS; b++)
+	free(h->buckets[b].entries);
+}
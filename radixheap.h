@@ -0,0 +1,86 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef NICC_RADIXHEAP_H
+#define NICC_RADIXHEAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common.h"
+
+#ifdef NICC_TYPEDEF
+typedef struct radixheap_t RadixHeap;
+#endif /* NICC_TYPEDEF */
+
+/* bucket 0 holds keys equal to the last popped key, bucket b keys differing from it in bit b - 1 */
+#define RADIXHEAP_BUCKETS 65
+
+struct radixheap_entry_t {
+    u64 key;
+    void *item;
+};
+
+struct radixheap_bucket_t {
+    struct radixheap_entry_t *entries;
+    u32 size;
+    u32 capacity;
+};
+
+/*
+ * Monotone priority queue of item pointers ordered by u64 keys, smallest first.
+ * Monotone means a pushed key may never be smaller than the last popped key,
+ * which holds for Dijkstra with non-negative integer weights and for event
+ * simulations that never schedule into the past.
+ *
+ * An item goes into the bucket of the highest bit its key differs in from the
+ * last popped key. Pop takes from bucket 0, and when that is empty it finds the
+ * smallest key of the lowest non-empty bucket and redistributes that bucket into
+ * lower ones. An item only ever moves to a lower bucket, so push and pop are
+ * amortized O(log C) where C is the spread of the keys, keys are only compared
+ * as integers and the buckets are scanned front to back.
+ */
+struct radixheap_t {
+    u64 last; // last popped key, every key in the heap is at least this
+    size_t size;
+    u64 occupied; // bit b - 1 set if bucket b is non-empty, for b >= 1
+    struct radixheap_bucket_t buckets[RADIXHEAP_BUCKETS];
+};
+
+void radixheap_init(struct radixheap_t *h);
+void radixheap_free(struct radixheap_t *h);
+
+/*
+ * returns false, without pushing, if key is smaller than the key popped last,
+ * which would break the monotone order
+ */
+bool radixheap_push(struct radixheap_t *h, void *item, u64 key);
+
+/*
+ * returns and removes the item with the smallest key, storing the key in key
+ * unless it is NULL. returns NULL if the heap is empty.
+ */
+void *radixheap_pop(struct radixheap_t *h, u64 *key);
+
+/* smallest key in the heap, UINT64_MAX if it is empty */
+u64 radixheap_top_key(struct radixheap_t *h);
+
+static inline size_t radixheap_size(struct radixheap_t *h)
+{
+    return h->size;
+}
+
+#endif /* NICC_RADIXHEAP_H */
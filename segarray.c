@@ -0,0 +1,119 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand, Callum Gran
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include "common.h"
+#include "segarray.h"
+
+/* segarray implementation */
+void segarray_init(struct segarray_t *arr, u32 T_size)
+{
+    arr->n_chunks = 0;
+    arr->T_size = T_size;
+    arr->size = 0;
+}
+
+void segarray_free(struct segarray_t *arr)
+{
+    for (u32 k = 0; k < arr->n_chunks; k++)
+	free(arr->chunks[k]);
+    arr->n_chunks = 0;
+    arr->size = 0;
+}
+
+static inline size_t chunk_cap(u32 k)
+{
+    return (size_t)1 << (k + SEGARRAY_FIRST_CHUNK_LOG2);
+}
+
+/* the elements in chunks 0..k-1 add up to chunk_cap(k) - chunk_cap(0) */
+static inline size_t total_cap(u32 n_chunks)
+{
+    return n_chunks == 0 ? 0 : chunk_cap(n_chunks) - chunk_cap(0);
+}
+
+static void *get_element(struct segarray_t *arr, size_t idx)
+{
+    u64 j = ((u64)idx >> SEGARRAY_FIRST_CHUNK_LOG2) + 1;
+    u32 k = 63 - nicc_clz64(j);
+    size_t offset = idx + chunk_cap(0) - chunk_cap(k);
+    return (u8 *)arr->chunks[k] + offset * arr->T_size;
+}
+
+static void ensure_capacity(struct segarray_t *arr, size_t idx)
+{
+    if (idx >= total_cap(arr->n_chunks)) {
+	/* add a chunk, the existing ones are left where they are */
+	u32 k = arr->n_chunks++;
+	arr->chunks[k] = nicc_internal_realloc(NULL, chunk_cap(k) * arr->T_size);
+    }
+}
+
+bool segarray_set(struct segarray_t *arr, void *val, size_t idx)
+{
+    /* same as arraylist_set(), setting past the end is not possible */
+    if (idx > arr->size)
+	return false;
+    ensure_capacity(arr, idx);
+    memcpy(get_element(arr, idx), val, arr->T_size);
+
+    if (idx == arr->size)
+	arr->size++;
+
+    return true;
+}
+
+bool segarray_append(struct segarray_t *arr, void *val)
+{
+    return segarray_set(arr, val, arr->size);
+}
+
+void *segarray_get(struct segarray_t *arr, size_t idx)
+{
+    if (idx >= arr->size)
+	return NULL;
+
+    return get_element(arr, idx);
+}
+
+void segarray_get_copy(struct segarray_t *arr, size_t idx, void *return_ptr)
+{
+    void *element = segarray_get(arr, idx);
+    if (element == NULL)
+	return;
+
+    memcpy(return_ptr, element, arr->T_size);
+}
+
+bool segarray_pop(struct segarray_t *arr)
+{
+    if (arr->size == 0)
+	return false;
+    arr->size--;
+    return true;
+}
+
+bool segarray_pop_and_copy(struct segarray_t *arr, void *return_ptr)
+{
+    if (arr->size == 0)
+	return false;
+
+    segarray_get_copy(arr, arr->size - 1, return_ptr);
+    arr->size--;
+    return true;
+}
@@ -0,0 +1,58 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand, Callum Gran
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef NICC_SEGARRAY_H
+#define NICC_SEGARRAY_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+#ifdef NICC_TYPEDEF
+typedef struct segarray_t SegArray;
+#endif /* NICC_TYPEDEF */
+
+#define SEGARRAY_FIRST_CHUNK_LOG2 3 // the first chunk holds 8 elements
+#define SEGARRAY_MAX_CHUNKS (64 - SEGARRAY_FIRST_CHUNK_LOG2)
+
+/*
+ * Dynamic array with stable element addresses.
+ * Elements are stored in chunks where chunk k holds twice as many elements as
+ * chunk k - 1. Growing allocates a new chunk and never moves the existing
+ * elements, so pointers returned by segarray_get() stay valid until the element
+ * is popped or the segarray is freed. The chunk holding an index is found by
+ * counting the leading zeros of the index, so lookups are still O(1).
+ */
+struct segarray_t {
+    void *chunks[SEGARRAY_MAX_CHUNKS];
+    u32 n_chunks;
+    u32 T_size;
+    size_t size;
+};
+
+void segarray_init(struct segarray_t *arr, u32 T_size);
+void segarray_free(struct segarray_t *arr);
+
+bool segarray_set(struct segarray_t *arr, void *val, size_t idx);
+bool segarray_append(struct segarray_t *arr, void *val);
+
+void *segarray_get(struct segarray_t *arr, size_t idx);
+void segarray_get_copy(struct segarray_t *arr, size_t idx, void *return_ptr);
+bool segarray_pop(struct segarray_t *arr);
+bool segarray_pop_and_copy(struct segarray_t *arr, void *return_ptr);
+
+#endif /* NICC_SEGARRAY_H */
@@ -0,0 +1,265 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "common.h"
+#include "skiplist.h"
+#include "slab.h"
+
+static size_t node_size(u32 level)
+{
+    return sizeof(struct skiplist_node_t) + level * sizeof(struct skiplist_link_t);
+}
+
+void skiplist_init(struct skiplist_t *sl, compare_fn_t *cmp, bool indexable)
+{
+    sl->head = nicc_internal_realloc(NULL, node_size(SKIPLIST_MAX_LEVEL));
+    sl->head->key = NULL;
+    sl->head->value = NULL;
+    sl->head->level = SKIPLIST_MAX_LEVEL;
+    for (u32 i = 0; i < SKIPLIST_MAX_LEVEL; i++) {
+	sl->head->links[i].next = NULL;
+	sl->head->links[i].width = 0;
+    }
+
+    sl->level = 1;
+    sl->size = 0;
+    sl->cmp = cmp;
+    sl->indexable = indexable;
+    sl->rng = 0x9e3779b97f4a7c15ULL;
+    for (u32 i = 0; i < SKIPLIST_MAX_LEVEL; i++)
+	slab_init(&sl->pools[i], node_size(i + 1));
+}
+
+void skiplist_free(struct skiplist_t *sl)
+{
+    /* the nodes live in the pools, so there is no need to walk the list */
+    for (u32 i = 0; i < SKIPLIST_MAX_LEVEL; i++)
+	slab_free(&sl->pools[i]);
+    free(sl->head);
+}
+
+/* each extra level has a 1/4 chance, taken two random bits at a time */
+static u32 random_level(struct skiplist_t *sl)
+{
+    /* xorshift64 */
+    u64 x = sl->rng;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    sl->rng = x;
+
+    u32 level = 1 + nicc_ctz64(x | ((u64)1 << 62)) / 2;
+    return level > SKIPLIST_MAX_LEVEL ? SKIPLIST_MAX_LEVEL : level;
+}
+
+/*
+ * walks down to the last node before key on every level. update[i] is that
+ * node on level i, and in indexable mode rank[i] is its position, counting the
+ * head as 0 and the first node as 1.
+ */
+static struct skiplist_node_t *find_preds(struct skiplist_t *sl, const void *key,
+					  struct skiplist_node_t **update, size_t *rank)
+{
+    struct skiplist_node_t *x = sl->head;
+    for (u32 i = sl->level; i-- > 0;) {
+	if (rank != NULL)
+	    rank[i] = i == sl->level - 1 ? 0 : rank[i + 1];
+	while (x->links[i].next != NULL && sl->cmp(x->links[i].next->key, key) < 0) {
+	    if (rank != NULL)
+		rank[i] += x->links[i].width;
+	    x = x->links[i].next;
+	}
+	update[i] = x;
+    }
+    return x->links[0].next;
+}
+
+bool skiplist_insert(struct skiplist_t *sl, void *key, void *value)
+{
+    struct skiplist_node_t *update[SKIPLIST_MAX_LEVEL];
+    size_t rank[SKIPLIST_MAX_LEVEL];
+    size_t *ranks = sl->indexable ? rank : NULL;
+
+    struct skiplist_node_t *found = find_preds(sl, key, update, ranks);
+    if (found != NULL && sl->cmp(found->key, key) == 0) {
+	found->key = key;
+	found->value = value;
+	return false;
+    }
+
+    u32 level = random_level(sl);
+    if (level > sl->level) {
+	for (u32 i = sl->level; i < level; i++) {
+	    rank[i] = 0;
+	    update[i] = sl->head;
+	    sl->head->links[i].width = sl->size;
+	}
+	sl->level = level;
+    }
+
+    struct skiplist_node_t *node = slab_alloc(&sl->pools[level - 1]);
+    node->key = key;
+    node->value = value;
+    node->level = level;
+    for (u32 i = 0; i < level; i++) {
+	node->links[i].next = update[i]->links[i].next;
+	update[i]->links[i].next = node;
+	if (sl->indexable) {
+	    /* the new node splits the link of update[i] in two */
+	    node->links[i].width = update[i]->links[i].width - (rank[0] - rank[i]);
+	    update[i]->links[i].width = rank[0] - rank[i] + 1;
+	}
+    }
+
+    /* links above the new node now skip one more node */
+    if (sl->indexable) {
+	for (u32 i = level; i < sl->level; i++)
+	    update[i]->links[i].width++;
+    }
+
+    sl->size++;
+    return true;
+}
+
+bool skiplist_remove(struct skiplist_t *sl, const void *key, void **value_out)
+{
+    struct skiplist_node_t *update[SKIPLIST_MAX_LEVEL];
+    struct skiplist_node_t *node = find_preds(sl, key, update, NULL);
+    if (node == NULL || sl->cmp(node->key, key) != 0)
+	return false;
+
+    for (u32 i = 0; i < sl->level; i++) {
+	if (update[i]->links[i].next == node) {
+	    if (sl->indexable)
+		update[i]->links[i].width += node->links[i].width - 1;
+	    update[i]->links[i].next = node->links[i].next;
+	} else if (sl->indexable) {
+	    update[i]->links[i].width--;
+	}
+    }
+
+    while (sl->level > 1 && sl->head->links[sl->level - 1].next == NULL)
+	sl->level--;
+
+    if (value_out != NULL)
+	*value_out = node->value;
+    slab_release(&sl->pools[node->level - 1], node);
+    sl->size--;
+    return true;
+}
+
+struct skiplist_node_t *skiplist_ceil(struct skiplist_t *sl, const void *key)
+{
+    struct skiplist_node_t *update[SKIPLIST_MAX_LEVEL];
+    return find_preds(sl, key, update, NULL);
+}
+
+struct skiplist_node_t *skiplist_find(struct skiplist_t *sl, const void *key)
+{
+    struct skiplist_node_t *node = skiplist_ceil(sl, key);
+    if (node == NULL || sl->cmp(node->key, key) != 0)
+	return NULL;
+    return node;
+}
+
+void *skiplist_get(struct skiplist_t *sl, const void *key)
+{
+    struct skiplist_node_t *node = skiplist_find(sl, key);
+    return node == NULL ? NULL : node->value;
+}
+
+struct skiplist_node_t *skiplist_floor(struct skiplist_t *sl, const void *key)
+{
+    struct skiplist_node_t *x = sl->head;
+    for (u32 i = sl->level; i-- > 0;) {
+	while (x->links[i].next != NULL && sl->cmp(x->links[i].next->key, key) <= 0)
+	    x = x->links[i].next;
+    }
+    return x == sl->head ? NULL : x;
+}
+
+struct skiplist_node_t *skiplist_first(struct skiplist_t *sl)
+{
+    return sl->head->links[0].next;
+}
+
+struct skiplist_node_t *skiplist_next(struct skiplist_node_t *node)
+{
+    return node->links[0].next;
+}
+
+void skiplist_range(struct skiplist_t *sl, const void *lo, const void *hi,
+		    struct skiplist_cursor_t *cursor)
+{
+    cursor->node = lo == NULL ? skiplist_first(sl) : skiplist_ceil(sl, lo);
+    cursor->hi = hi;
+    cursor->cmp = sl->cmp;
+}
+
+struct skiplist_node_t *skiplist_cursor_next(struct skiplist_cursor_t *cursor)
+{
+    struct skiplist_node_t *node = cursor->node;
+    if (node == NULL)
+	return NULL;
+    if (cursor->hi != NULL && cursor->cmp(node->key, cursor->hi) >= 0) {
+	cursor->node = NULL;
+	return NULL;
+    }
+
+    cursor->node = node->links[0].next;
+    return node;
+}
+
+size_t skiplist_rank(struct skiplist_t *sl, const void *key)
+{
+    if (!sl->indexable)
+	return NICC_NOT_FOUND;
+
+    size_t rank = 0;
+    struct skiplist_node_t *x = sl->head;
+    for (u32 i = sl->level; i-- > 0;) {
+	while (x->links[i].next != NULL && sl->cmp(x->links[i].next->key, key) <= 0) {
+	    rank += x->links[i].width;
+	    x = x->links[i].next;
+	}
+	if (x != sl->head && sl->cmp(x->key, key) == 0)
+	    return rank - 1;
+    }
+    return NICC_NOT_FOUND;
+}
+
+struct skiplist_node_t *skiplist_select(struct skiplist_t *sl, size_t idx)
+{
+    if (!sl->indexable || idx >= sl->size)
+	return NULL;
+
+    /* positions count from 1, the head is at 0 */
+    size_t target = idx + 1;
+    size_t traversed = 0;
+    struct skiplist_node_t *x = sl->head;
+    for (u32 i = sl->level; i-- > 0;) {
+	while (x->links[i].next != NULL && traversed + x->links[i].width <= target) {
+	    traversed += x->links[i].width;
+	    x = x->links[i].next;
+	}
+	if (traversed == target)
+	    return x;
+    }
+    return NULL;
+}
@@ -0,0 +1,115 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef NICC_SKIPLIST_H
+#define NICC_SKIPLIST_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "common.h"
+#include "slab.h"
+
+#ifdef NICC_TYPEDEF
+typedef struct skiplist_t SkipList;
+typedef struct skiplist_node_t SkipListNode;
+#endif /* NICC_TYPEDEF */
+
+#define SKIPLIST_MAX_LEVEL 32
+
+struct skiplist_node_t;
+
+struct skiplist_link_t {
+    struct skiplist_node_t *next;
+    size_t width; // nodes passed by following this link, only kept in indexable mode
+};
+
+struct skiplist_node_t {
+    void *key; // we don't manage the memory of key and value
+    void *value;
+    u32 level;
+    struct skiplist_link_t links[];
+};
+
+/*
+ * Ordered map on top of a skip list, keys are ordered by cmp.
+ * Every node is on level 0 and on each level above it with probability 1/4,
+ * giving O(log n) expected search, insert and remove. The nodes are allocated
+ * from one slab pool per node height. In indexable mode every link also stores
+ * how many nodes it skips, which makes rank and select O(log n) too.
+ */
+struct skiplist_t {
+    struct skiplist_node_t *head; // sentinel with SKIPLIST_MAX_LEVEL links
+    u32 level; // levels currently in use
+    size_t size;
+    compare_fn_t *cmp;
+    bool indexable;
+    u64 rng;
+    struct slab_t pools[SKIPLIST_MAX_LEVEL]; // pools[i] holds nodes with i + 1 links
+};
+
+/*
+ * Iterates the nodes in [lo, hi). Set up by skiplist_range().
+ */
+struct skiplist_cursor_t {
+    struct skiplist_node_t *node;
+    const void *hi;
+    compare_fn_t *cmp;
+};
+
+void skiplist_init(struct skiplist_t *sl, compare_fn_t *cmp, bool indexable);
+void skiplist_free(struct skiplist_t *sl);
+
+/*
+ * Inserts the key value pair. If an equal key already exists its key and value
+ * are replaced and false is returned.
+ */
+bool skiplist_insert(struct skiplist_t *sl, void *key, void *value);
+
+/*
+ * Removes key. If value_out is not NULL it is set to the value of the removed
+ * node.
+ */
+bool skiplist_remove(struct skiplist_t *sl, const void *key, void **value_out);
+
+/* returns the value stored under key, NULL if not found */
+void *skiplist_get(struct skiplist_t *sl, const void *key);
+struct skiplist_node_t *skiplist_find(struct skiplist_t *sl, const void *key);
+
+/* greatest node with a key <= key and smallest node with a key >= key, or NULL */
+struct skiplist_node_t *skiplist_floor(struct skiplist_t *sl, const void *key);
+struct skiplist_node_t *skiplist_ceil(struct skiplist_t *sl, const void *key);
+
+struct skiplist_node_t *skiplist_first(struct skiplist_t *sl);
+struct skiplist_node_t *skiplist_next(struct skiplist_node_t *node);
+
+/*
+ * Positions cursor at the first node with a key >= lo. skiplist_cursor_next()
+ * then returns the nodes in order until a key >= hi is reached. A NULL lo
+ * starts at the first node and a NULL hi runs to the end.
+ */
+void skiplist_range(struct skiplist_t *sl, const void *lo, const void *hi,
+		    struct skiplist_cursor_t *cursor);
+struct skiplist_node_t *skiplist_cursor_next(struct skiplist_cursor_t *cursor);
+
+/*
+ * Indexable mode only. rank returns the 0-based position of key, or
+ * NICC_NOT_FOUND, and select returns the node at position idx, or NULL.
+ */
+size_t skiplist_rank(struct skiplist_t *sl, const void *key);
+struct skiplist_node_t *skiplist_select(struct skiplist_t *sl, size_t idx);
+
+#endif /* NICC_SKIPLIST_H */
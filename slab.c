@@ -0,0 +1,135 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "common.h"
+#include "slab.h"
+
+struct slab_chunk_t {
+    struct slab_chunk_t *next;
+    /* keeps the objects that follow the header aligned for any type */
+    max_align_t objects[];
+};
+
+void slab_init(struct slab_t *slab, size_t obj_size)
+{
+    /* released objects store the free list link in themselves */
+    if (obj_size < sizeof(void *))
+	obj_size = sizeof(void *);
+    /* every object starts a multiple of the alignment of max_align_t into its chunk */
+    size_t align = _Alignof(max_align_t);
+    slab->obj_size = (obj_size + align - 1) & ~(align - 1);
+
+    slab->chunks = NULL;
+    slab->oldest = NULL;
+    slab->free_list = NULL;
+    slab->free_tail = NULL;
+    slab->used = 0;
+    slab->chunk_cap = 0;
+}
+
+void slab_free(struct slab_t *slab)
+{
+    struct slab_chunk_t *chunk = slab->chunks;
+    while (chunk != NULL) {
+	struct slab_chunk_t *next = chunk->next;
+	free(chunk);
+	chunk = next;
+    }
+
+    slab->chunks = NULL;
+    slab->oldest = NULL;
+    slab->free_list = NULL;
+    slab->free_tail = NULL;
+    slab->used = 0;
+    slab->chunk_cap = 0;
+}
+
+static void add_chunk(struct slab_t *slab)
+{
+    size_t cap = slab->chunk_cap == 0 ? SLAB_FIRST_CHUNK_CAP : slab->chunk_cap * 2;
+    if (cap > SLAB_MAX_CHUNK_CAP)
+	cap = SLAB_MAX_CHUNK_CAP;
+
+    struct slab_chunk_t *chunk =
+	nicc_internal_realloc(NULL, sizeof(struct slab_chunk_t) + cap * slab->obj_size);
+    chunk->next = slab->chunks;
+    if (slab->chunks == NULL)
+	slab->oldest = chunk;
+    slab->chunks = chunk;
+    slab->chunk_cap = cap;
+    slab->used = 0;
+}
+
+void *slab_alloc(struct slab_t *slab)
+{
+    if (slab->free_list != NULL) {
+	void *obj = slab->free_list;
+	slab->free_list = *(void **)obj;
+	if (slab->free_list == NULL)
+	    slab->free_tail = NULL;
+	return obj;
+    }
+
+    if (slab->used == slab->chunk_cap)
+	add_chunk(slab);
+
+    return (u8 *)slab->chunks->objects + slab->used++ * slab->obj_size;
+}
+
+void slab_release(struct slab_t *slab, void *obj)
+{
+    *(void **)obj = slab->free_list;
+    if (slab->free_list == NULL)
+	slab->free_tail = obj;
+    slab->free_list = obj;
+}
+
+void slab_adopt(struct slab_t *slab, struct slab_t *other)
+{
+    if (other->chunks == NULL)
+	return;
+
+    if (slab->chunks == NULL) {
+	/* nothing to keep carving from, continue where other left off */
+	slab->chunks = other->chunks;
+	slab->oldest = other->oldest;
+	slab->used = other->used;
+	slab->chunk_cap = other->chunk_cap;
+    } else {
+	/* the newest chunk stays first so slab keeps carving out of it */
+	other->oldest->next = slab->chunks->next;
+	if (slab->chunks->next == NULL)
+	    slab->oldest = other->oldest;
+	slab->chunks->next = other->chunks;
+    }
+
+    if (other->free_list != NULL) {
+	*(void **)other->free_tail = slab->free_list;
+	if (slab->free_list == NULL)
+	    slab->free_tail = other->free_tail;
+	slab->free_list = other->free_list;
+    }
+
+    other->chunks = NULL;
+    other->oldest = NULL;
+    other->free_list = NULL;
+    other->free_tail = NULL;
+    other->used = 0;
+    other->chunk_cap = 0;
+}
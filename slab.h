@@ -0,0 +1,66 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef NICC_SLAB_H
+#define NICC_SLAB_H
+
+#include <stdlib.h>
+
+#include "common.h"
+
+#ifdef NICC_TYPEDEF
+typedef struct slab_t Slab;
+#endif /* NICC_TYPEDEF */
+
+#define SLAB_FIRST_CHUNK_CAP 16 // objects in the first chunk
+#define SLAB_MAX_CHUNK_CAP 4096 // chunks double in size up to this many objects
+
+struct slab_chunk_t;
+
+/*
+ * Pool of fixed size objects.
+ * Objects are carved out of contiguous chunks, and released objects are kept on
+ * an internal free list threaded through the objects themselves, so allocating
+ * and releasing is O(1) and never calls malloc/free once the pool is warm.
+ * slab_free() releases every chunk at once, including the objects that were
+ * never released.
+ */
+struct slab_t {
+    struct slab_chunk_t *chunks; // newest chunk first, objects are carved out of it
+    struct slab_chunk_t *oldest; // last chunk in the chain
+    void *free_list;
+    void *free_tail; // last object on the free list, so slab_adopt() can append to it
+    size_t obj_size;
+    size_t used; // objects carved out of the newest chunk
+    size_t chunk_cap; // objects that fit in the newest chunk
+};
+
+/* obj_size is rounded up so that every object is aligned for any type */
+void slab_init(struct slab_t *slab, size_t obj_size);
+void slab_free(struct slab_t *slab);
+
+void *slab_alloc(struct slab_t *slab);
+void slab_release(struct slab_t *slab, void *obj);
+
+/*
+ * Moves every chunk of other into slab in O(1), so objects allocated from other
+ * are owned by slab from now on. The free list of other is linked in front of
+ * the one of slab, so objects released to other are handed out again.
+ * Both slabs must have the same object size. other is left empty.
+ */
+void slab_adopt(struct slab_t *slab, struct slab_t *other);
+
+#endif /* NICC_SLAB_H */
@@ -0,0 +1,156 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+
+#include "common.h"
+#include "heapq.h"
+#include "sort.h"
+
+static void insertion_sort(u8 *a, size_t n, size_t size, compare_fn_t *cmp)
+{
+    for (size_t i = 1; i < n; i++) {
+	for (size_t j = i; j > 0 && cmp(a + (j - 1) * size, a + j * size) > 0; j--)
+	    nicc_data_swap(a + (j - 1) * size, a + j * size, size);
+    }
+}
+
+static inline void sort_two(u8 *a, u8 *b, size_t size, compare_fn_t *cmp)
+{
+    if (cmp(a, b) > 0)
+	nicc_data_swap(a, b, size);
+}
+
+/*
+ * moves the median of the first, middle and last element to the front as the
+ * pivot. the smaller one ends up at index 1 and the larger one last, so neither
+ * partition scan can run off the range.
+ */
+static void choose_pivot(u8 *a, size_t n, size_t size, compare_fn_t *cmp)
+{
+    u8 *lo = a + size;
+    u8 *mid = a + (n / 2) * size;
+    u8 *hi = a + (n - 1) * size;
+    sort_two(lo, mid, size, cmp);
+    sort_two(mid, hi, size, cmp);
+    sort_two(lo, mid, size, cmp);
+    nicc_data_swap(a, mid, size);
+}
+
+/*
+ * Hoare partition around the pivot at a[0]. both scans stop on elements equal
+ * to the pivot, which keeps ranges full of duplicates balanced. returns the
+ * final index of the pivot.
+ */
+static size_t partition(u8 *a, size_t n, size_t size, compare_fn_t *cmp)
+{
+    size_t i = 0;
+    size_t j = n;
+    for (;;) {
+	while (cmp(a + ++i * size, a) < 0)
+	    ;
+	while (cmp(a + --j * size, a) > 0)
+	    ;
+	if (i >= j)
+	    break;
+	nicc_data_swap(a + i * size, a + j * size, size);
+    }
+    nicc_data_swap(a, a + j * size, size);
+    return j;
+}
+
+static void introsort(u8 *a, size_t n, size_t size, compare_fn_t *cmp, u32 depth)
+{
+    while (n > SORT_INSERTION_THRESHOLD) {
+	if (depth-- == 0) {
+	    heap_sort_ascending(a, n, size, cmp);
+	    return;
+	}
+
+	choose_pivot(a, n, size, cmp);
+	size_t p = partition(a, n, size, cmp);
+
+	/* recurse into the smaller side and loop on the larger, bounding the stack */
+	size_t left = p;
+	size_t right = n - p - 1;
+	if (left < right) {
+	    introsort(a, left, size, cmp, depth);
+	    a += (p + 1) * size;
+	    n = right;
+	} else {
+	    introsort(a + (p + 1) * size, right, size, cmp, depth);
+	    n = left;
+	}
+    }
+    insertion_sort(a, n, size, cmp);
+}
+
+static inline u32 depth_limit(size_t nmemb)
+{
+    return 2 * (63 - nicc_clz64((u64)nmemb));
+}
+
+void nicc_sort(void *base, size_t nmemb, size_t size, compare_fn_t *cmp)
+{
+    if (nmemb < 2)
+	return;
+
+    introsort(base, nmemb, size, cmp, depth_limit(nmemb));
+}
+
+void nicc_nth_element(void *base, size_t nmemb, size_t size, size_t n, compare_fn_t *cmp)
+{
+    if (n >= nmemb)
+	return;
+
+    u8 *a = base;
+    u32 depth = depth_limit(nmemb);
+    while (nmemb > SORT_INSERTION_THRESHOLD) {
+	if (depth-- == 0) {
+	    heap_sort_ascending(a, nmemb, size, cmp);
+	    return;
+	}
+
+	choose_pivot(a, nmemb, size, cmp);
+	size_t p = partition(a, nmemb, size, cmp);
+	if (p == n)
+	    return;
+
+	/* only the side holding n needs to be looked at again */
+	if (n < p) {
+	    nmemb = p;
+	} else {
+	    a += (p + 1) * size;
+	    nmemb -= p + 1;
+	    n -= p + 1;
+	}
+    }
+    insertion_sort(a, nmemb, size, cmp);
+}
+
+void nicc_partial_sort(void *base, size_t nmemb, size_t size, size_t k, compare_fn_t *cmp)
+{
+    if (k >= nmemb) {
+	nicc_sort(base, nmemb, size, cmp);
+	return;
+    }
+    if (k == 0)
+	return;
+
+    /* the k-th smallest lands at k - 1 with everything smaller in front of it */
+    nicc_nth_element(base, nmemb, size, k - 1, cmp);
+    nicc_sort(base, k - 1, size, cmp);
+}
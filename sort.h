@@ -0,0 +1,75 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef NICC_SORT_H
+#define NICC_SORT_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "arraylist.h"
+#include "common.h"
+
+#define SORT_INSERTION_THRESHOLD 16 // ranges this small are insertion sorted
+
+/*
+ * Sorts base in place into ascending order, a drop in replacement for qsort().
+ * Introsort: quicksort with a median of three pivot, which hands ranges that
+ * recurse deeper than 2 log2(n) to heap_sort_ascending(), so the worst case is
+ * O(n log n). Small ranges are finished with insertion sort. Not stable.
+ */
+void nicc_sort(void *base, size_t nmemb, size_t size, compare_fn_t *cmp);
+
+/*
+ * Like std::nth_element: reorders base so the element at index n is the one that
+ * would be there if base was sorted, with no greater element before it and no
+ * smaller one after it. Introselect: quickselect that only follows the side
+ * holding n, so O(n) on average, and falls back to heap_sort_ascending() on the
+ * remaining range after 2 log2(n) bad partitions. Does nothing if n >= nmemb.
+ */
+void nicc_nth_element(void *base, size_t nmemb, size_t size, size_t n, compare_fn_t *cmp);
+
+/*
+ * Sorts the k smallest elements into base[0..k) in ascending order, leaving the
+ * rest in unspecified order. O(nmemb + k log k) on average by selecting with
+ * nicc_nth_element() and then only sorting the selected prefix.
+ */
+void nicc_partial_sort(void *base, size_t nmemb, size_t size, size_t k, compare_fn_t *cmp);
+
+/*
+ * The above over the elements of an arraylist. They live here rather than in
+ * arraylist.c so the arraylist module links without sort.c. nth_element returns
+ * false if n is out of bounds, partial_sort if the arraylist is empty.
+ */
+static inline bool arraylist_nth_element(struct arraylist_t *arr, size_t n, compare_fn_t *cmp)
+{
+    if (n >= arr->size)
+	return false;
+
+    nicc_nth_element(arr->data, arr->size, arr->T_size, n, cmp);
+    return true;
+}
+
+static inline bool arraylist_partial_sort(struct arraylist_t *arr, size_t k, compare_fn_t *cmp)
+{
+    if (arr->size == 0)
+	return false;
+
+    nicc_partial_sort(arr->data, arr->size, arr->T_size, k, cmp);
+    return true;
+}
+
+#endif /* NICC_SORT_H */
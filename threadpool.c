@@ -0,0 +1,131 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand, Callum Gran
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE /* sysconf(_SC_NPROCESSORS_ONLN) */
+#endif
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "threadpool.h"
+
+struct worker_arg_t {
+    struct threadpool_t *pool;
+    u32 id;
+};
+
+static void *worker(void *arg)
+{
+    struct threadpool_t *pool = ((struct worker_arg_t *)arg)->pool;
+    u32 id = ((struct worker_arg_t *)arg)->id;
+    free(arg);
+
+    u64 seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    while (true) {
+	while (!pool->stop && pool->generation == seen)
+	    pthread_cond_wait(&pool->work_cond, &pool->lock);
+	if (pool->stop)
+	    break;
+
+	seen = pool->generation;
+	threadpool_fn_t *fn = pool->fn;
+	void *ctx = pool->ctx;
+	pthread_mutex_unlock(&pool->lock);
+
+	fn(ctx, id);
+
+	pthread_mutex_lock(&pool->lock);
+	if (--pool->active == 0)
+	    pthread_cond_signal(&pool->done_cond);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+void threadpool_init(struct threadpool_t *pool, u32 n_threads)
+{
+    if (n_threads == 0) {
+	long online = sysconf(_SC_NPROCESSORS_ONLN);
+	n_threads = online > 1 ? (u32)online - 1 : 0;
+    }
+
+    pool->fn = NULL;
+    pool->ctx = NULL;
+    pool->generation = 0;
+    pool->active = 0;
+    pool->stop = false;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+    pool->threads = GROW_ARRAY(pthread_t, NULL, n_threads > 0 ? n_threads : 1);
+    pool->n_threads = 0;
+    for (u32 i = 0; i < n_threads; i++) {
+	struct worker_arg_t *arg = malloc(sizeof(struct worker_arg_t));
+	if (arg == NULL)
+	    break;
+	arg->pool = pool;
+	arg->id = i;
+	if (pthread_create(&pool->threads[i], NULL, worker, arg) != 0) {
+	    /* run with the threads we got */
+	    free(arg);
+	    break;
+	}
+	pool->n_threads++;
+    }
+}
+
+void threadpool_free(struct threadpool_t *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (u32 i = 0; i < pool->n_threads; i++)
+	pthread_join(pool->threads[i], NULL);
+
+    free(pool->threads);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_cond_destroy(&pool->done_cond);
+}
+
+void threadpool_run(struct threadpool_t *pool, threadpool_fn_t *fn, void *ctx)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->ctx = ctx;
+    pool->active = pool->n_threads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    fn(ctx, pool->n_threads);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active > 0)
+	pthread_cond_wait(&pool->done_cond, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+u32 threadpool_width(struct threadpool_t *pool)
+{
+    return pool->n_threads + 1;
+}
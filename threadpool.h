@@ -0,0 +1,64 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand, Callum Gran
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef NICC_THREADPOOL_H
+#define NICC_THREADPOOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "common.h"
+
+#ifdef NICC_TYPEDEF
+typedef struct threadpool_t ThreadPool;
+#endif /* NICC_TYPEDEF */
+
+/* called once on every worker with its id in [0, threadpool_width()) */
+typedef void threadpool_fn_t(void *ctx, u32 worker_id);
+
+/*
+ * Small fixed size pool of pthreads that all run the same job, meant for data
+ * parallel loops where the job itself hands out chunks of work to the workers.
+ * The thread calling threadpool_run() takes part as the last worker. Only one
+ * job can run on a pool at a time.
+ */
+struct threadpool_t {
+    pthread_t *threads;
+    u32 n_threads; // threads owned by the pool, not counting the caller
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+    threadpool_fn_t *fn;
+    void *ctx;
+    u64 generation; // bumped for every job so workers can tell a new one apart
+    u32 active; // workers that have not finished the current job
+    bool stop;
+};
+
+/*
+ * Starts n_threads worker threads. If n_threads is 0 one thread less than the
+ * amount of online CPUs is used, as the caller also does work.
+ */
+void threadpool_init(struct threadpool_t *pool, u32 n_threads);
+void threadpool_free(struct threadpool_t *pool);
+
+/* runs fn on every worker and returns once all of them are done */
+void threadpool_run(struct threadpool_t *pool, threadpool_fn_t *fn, void *ctx);
+
+/* the amount of workers a job is run on, including the calling thread */
+u32 threadpool_width(struct threadpool_t *pool);
+
+#endif /* NICC_THREADPOOL_H */
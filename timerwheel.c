@@ -0,0 +1,169 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdbool.h>
+
+#include "common.h"
+#include "ilist.h"
+#include "timerwheel.h"
+
+#define SLOT_MASK (TIMERWHEEL_SLOTS - 1)
+
+static inline u32 level_shift(u32 level)
+{
+    return level * TIMERWHEEL_SLOT_BITS;
+}
+
+/* links timer into the slot that covers its expiry, relative to the clock */
+static void place(struct timerwheel_t *wheel, struct timerwheel_timer_t *timer)
+{
+    u64 target = timer->expires;
+    if (target - wheel->now >= TIMERWHEEL_RANGE)
+	/* out of reach, revisited when the top level slot cascades */
+	target = wheel->now + TIMERWHEEL_RANGE - 1;
+
+    u64 delta = target - wheel->now;
+    u32 level = 0;
+    while (level < TIMERWHEEL_LEVELS - 1 && delta >= (u64)1 << level_shift(level + 1))
+	level++;
+
+    u32 slot = (u32)(target >> level_shift(level)) & SLOT_MASK;
+    ilist_push_back(&wheel->slots[level][slot], &timer->node);
+    wheel->occupied[level] |= (u64)1 << slot;
+}
+
+/*
+ * the clock just entered the span of the slot of level that covers it, so its
+ * timers are redistributed over the levels below. the levels above go first, as
+ * they may drop timers into this very slot.
+ */
+static void cascade(struct timerwheel_t *wheel, u32 level)
+{
+    u32 slot = (u32)(wheel->now >> level_shift(level)) & SLOT_MASK;
+    if (slot == 0 && level + 1 < TIMERWHEEL_LEVELS)
+	cascade(wheel, level + 1);
+
+    if (!(wheel->occupied[level] & ((u64)1 << slot)))
+	return;
+    wheel->occupied[level] &= ~((u64)1 << slot);
+
+    struct ilist_t pending;
+    ilist_init(&pending);
+    ilist_splice_back(&pending, &wheel->slots[level][slot]);
+    struct ilist_node_t *node;
+    while ((node = ilist_pop_front(&pending)) != NULL)
+	place(wheel, NICC_CONTAINER_OF(node, struct timerwheel_timer_t, node));
+}
+
+void timerwheel_init(struct timerwheel_t *wheel, u64 now)
+{
+    wheel->now = now;
+    wheel->size = 0;
+    for (u32 level = 0; level < TIMERWHEEL_LEVELS; level++) {
+	wheel->occupied[level] = 0;
+	for (u32 slot = 0; slot < TIMERWHEEL_SLOTS; slot++)
+	    ilist_init(&wheel->slots[level][slot]);
+    }
+}
+
+void timerwheel_timer_init(struct timerwheel_timer_t *timer)
+{
+    ilist_node_init(&timer->node);
+    timer->expires = 0;
+}
+
+void timerwheel_schedule(struct timerwheel_t *wheel, struct timerwheel_timer_t *timer, u64 expires)
+{
+    if (timerwheel_pending(timer))
+	ilist_unlink(&timer->node);
+    else
+	wheel->size++;
+
+    timer->expires = expires > wheel->now ? expires : wheel->now + 1;
+    place(wheel, timer);
+}
+
+bool timerwheel_cancel(struct timerwheel_t *wheel, struct timerwheel_timer_t *timer)
+{
+    if (!timerwheel_pending(timer))
+	return false;
+
+    /* the occupied bit of the slot is left set and cleared when the slot is visited */
+    ilist_unlink(&timer->node);
+    wheel->size--;
+    return true;
+}
+
+/*
+ * first tick after now at which the clock reaches a slot that may hold timers,
+ * either a level 0 slot that is due or a higher level slot that cascades
+ */
+static u64 next_event(struct timerwheel_t *wheel)
+{
+    u64 next = UINT64_MAX;
+    for (u32 level = 0; level < TIMERWHEEL_LEVELS; level++) {
+	u64 occupied = wheel->occupied[level];
+	if (occupied == 0)
+	    continue;
+
+	/* rotate the slots right after the current one to the bottom */
+	u64 block = wheel->now >> level_shift(level);
+	u32 r = (u32)(block + 1) & SLOT_MASK;
+	u64 ahead = r == 0 ? occupied : (occupied >> r) | (occupied << (64 - r));
+	u64 tick = (block + 1 + nicc_ctz64(ahead)) << level_shift(level);
+	if (tick < next)
+	    next = tick;
+    }
+    return next;
+}
+
+size_t timerwheel_advance(struct timerwheel_t *wheel, u64 to, timerwheel_fn_t *fn, void *ctx)
+{
+    size_t fired = 0;
+    while (wheel->now < to) {
+	/* skip straight past the ticks where nothing happens */
+	u64 tick = wheel->size > 0 ? next_event(wheel) : UINT64_MAX;
+	if (tick > to) {
+	    wheel->now = to;
+	    break;
+	}
+
+	u32 slot = (u32)tick & SLOT_MASK;
+	wheel->now = tick;
+	if (slot == 0)
+	    cascade(wheel, 1);
+
+	if (!(wheel->occupied[0] & ((u64)1 << slot)))
+	    continue;
+	wheel->occupied[0] &= ~((u64)1 << slot);
+
+	/*
+	 * every timer is unlinked before its callback runs, so the callback is free
+	 * to reschedule it or cancel any other timer, including those still due
+	 */
+	struct ilist_t due;
+	ilist_init(&due);
+	ilist_splice_back(&due, &wheel->slots[0][slot]);
+	struct ilist_node_t *node;
+	while ((node = ilist_pop_front(&due)) != NULL) {
+	    wheel->size--;
+	    fired++;
+	    fn(NICC_CONTAINER_OF(node, struct timerwheel_timer_t, node), ctx);
+	}
+    }
+
+    return fired;
+}
@@ -0,0 +1,90 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef NICC_TIMERWHEEL_H
+#define NICC_TIMERWHEEL_H
+
+#include <stdbool.h>
+
+#include "common.h"
+#include "ilist.h"
+
+#ifdef NICC_TYPEDEF
+typedef struct timerwheel_t TimerWheel;
+typedef struct timerwheel_timer_t TimerWheelTimer;
+#endif /* NICC_TYPEDEF */
+
+#define TIMERWHEEL_SLOT_BITS 6
+#define TIMERWHEEL_SLOTS (1 << TIMERWHEEL_SLOT_BITS)
+#define TIMERWHEEL_LEVELS 4
+/* timers further out than this many ticks are parked on the last slot of the top level */
+#define TIMERWHEEL_RANGE ((u64)1 << (TIMERWHEEL_SLOT_BITS * TIMERWHEEL_LEVELS))
+
+struct timerwheel_timer_t;
+
+/* called for every timer that fires, with the ctx given to timerwheel_advance() */
+typedef void timerwheel_fn_t(struct timerwheel_timer_t *timer, void *ctx);
+
+/*
+ * Timer embedded in the user struct, recovered with NICC_CONTAINER_OF() once it
+ * fires. Must be initialized with timerwheel_timer_init() before first use.
+ */
+struct timerwheel_timer_t {
+    struct ilist_node_t node;
+    u64 expires; // absolute tick
+};
+
+/*
+ * Hierarchical timing wheel.
+ * Level 0 has one slot per tick for the next 64 ticks, every level above has
+ * slots 64 times as wide. A timer goes into the lowest level that reaches its
+ * expiry, and when the clock enters the span of a higher level slot, its timers
+ * cascade down to the levels below. Schedule and cancel are O(1), as is
+ * advancing the clock amortized over the timers, and nothing is allocated.
+ * The wheel does not read any clock, ticks are whatever unit the caller uses.
+ */
+struct timerwheel_t {
+    u64 now;
+    size_t size;
+    u64 occupied[TIMERWHEEL_LEVELS]; // bit set for slots that may hold timers
+    struct ilist_t slots[TIMERWHEEL_LEVELS][TIMERWHEEL_SLOTS];
+};
+
+void timerwheel_init(struct timerwheel_t *wheel, u64 now);
+void timerwheel_timer_init(struct timerwheel_timer_t *timer);
+
+/*
+ * Schedules timer to fire at tick expires, moving it if it was already
+ * scheduled. A timer that expires at or before now fires on the next advance.
+ */
+void timerwheel_schedule(struct timerwheel_t *wheel, struct timerwheel_timer_t *timer, u64 expires);
+
+/* returns false if the timer was not scheduled */
+bool timerwheel_cancel(struct timerwheel_t *wheel, struct timerwheel_timer_t *timer);
+
+static inline bool timerwheel_pending(struct timerwheel_timer_t *timer)
+{
+    return ilist_node_linked(&timer->node);
+}
+
+/*
+ * Moves the clock forward to tick to and calls fn for every timer that expires
+ * on the way, in order of expiry. A timer is no longer scheduled when fn is
+ * called with it, and fn may reschedule it. Returns the amount of timers fired.
+ */
+size_t timerwheel_advance(struct timerwheel_t *wheel, u64 to, timerwheel_fn_t *fn, void *ctx);
+
+#endif /* NICC_TIMERWHEEL_H */
@@ -0,0 +1,98 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common.h"
+#include "heapq.h"
+#include "topk.h"
+
+void nicc_topk_init(struct nicc_topk_t *t, size_t k, u32 T_size, compare_fn_t *cmp)
+{
+    heapq_init_copy(&t->heap, T_size, cmp);
+    t->k = k;
+}
+
+void nicc_topk_free(struct nicc_topk_t *t)
+{
+    heapq_free(&t->heap);
+}
+
+static inline bool topk_full(struct nicc_topk_t *t)
+{
+    return (size_t)t->heap.size >= t->k;
+}
+
+bool nicc_topk_push(struct nicc_topk_t *t, const void *item)
+{
+    if (!topk_full(t)) {
+	heapq_push_copy(&t->heap, item);
+	return true;
+    }
+
+    /* the early reject, the top of the heap is always the first element of values */
+    if (t->k == 0 || t->heap.cmp(item, t->heap.values) <= 0)
+	return false;
+
+    heapq_replace_copy(&t->heap, item, NULL);
+    return true;
+}
+
+bool nicc_topk_push_key(struct nicc_topk_t *t, const void *item, u64 key)
+{
+    if (!topk_full(t)) {
+	heapq_push_copy_key(&t->heap, item, key);
+	return true;
+    }
+
+    if (t->k == 0 || key <= t->heap.keys[0])
+	return false;
+
+    heapq_replace_copy_key(&t->heap, item, key, NULL);
+    return true;
+}
+
+size_t nicc_topk_size(struct nicc_topk_t *t)
+{
+    return (size_t)t->heap.size;
+}
+
+const void *nicc_topk_threshold(struct nicc_topk_t *t)
+{
+    if (t->k == 0 || !topk_full(t))
+	return NULL;
+    return t->heap.values;
+}
+
+u64 nicc_topk_threshold_key(struct nicc_topk_t *t)
+{
+    if (t->k == 0 || !topk_full(t))
+	return 0;
+    return heapq_top_key(&t->heap);
+}
+
+size_t nicc_topk_sorted(struct nicc_topk_t *t, void *out, u64 *keys)
+{
+    /* the heap pops the worst item first, so out is filled from the back */
+    size_t n = (size_t)t->heap.size;
+    for (size_t i = n; i-- > 0;) {
+	if (keys != NULL && t->heap.keys != NULL)
+	    keys[i] = heapq_top_key(&t->heap);
+	heapq_pop_copy(&t->heap, (u8 *)out + i * t->heap.T_size);
+    }
+    return n;
+}
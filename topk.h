@@ -0,0 +1,73 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef NICC_TOPK_H
+#define NICC_TOPK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common.h"
+#include "heapq.h"
+
+#ifdef NICC_TYPEDEF
+typedef struct nicc_topk_t TopK;
+#endif /* NICC_TYPEDEF */
+
+/*
+ * Streaming top-k selector: keeps the k greatest items, by cmp or by u64 key, of
+ * everything pushed into it using O(k) memory, regardless of the stream length.
+ *
+ * The items are kept in a copy heapq with the worst kept item at the top. Once k
+ * items are kept that item is the threshold, and an item that does not beat it
+ * is rejected with a single comparison and never touches the heap. On a long
+ * stream almost every item is rejected this way, so selecting the top 100 of
+ * 100M costs little more than one comparison per item.
+ *
+ * For the k smallest items pass a reversed cmp, or UINT64_MAX - key.
+ */
+struct nicc_topk_t {
+    struct heapq_t heap;
+    size_t k;
+};
+
+/* if cmp is NULL the selector is keyed and items must be pushed with nicc_topk_push_key() */
+void nicc_topk_init(struct nicc_topk_t *t, size_t k, u32 T_size, compare_fn_t *cmp);
+void nicc_topk_free(struct nicc_topk_t *t);
+
+/* copies item into the selector if it is among the k greatest so far, returns whether it was */
+bool nicc_topk_push(struct nicc_topk_t *t, const void *item);
+bool nicc_topk_push_key(struct nicc_topk_t *t, const void *item, u64 key);
+
+/* number of items kept, at most k */
+size_t nicc_topk_size(struct nicc_topk_t *t);
+
+/*
+ * the worst item kept, which a new item must beat to get in, or NULL while fewer
+ * than k items are kept. the keyed version returns 0 in that case.
+ */
+const void *nicc_topk_threshold(struct nicc_topk_t *t);
+u64 nicc_topk_threshold_key(struct nicc_topk_t *t);
+
+/*
+ * moves the kept items into out sorted from the greatest, along with their keys
+ * into keys if the selector is keyed and keys is not NULL. out must have room for
+ * nicc_topk_size() items. leaves the selector empty and returns the number of
+ * items written.
+ */
+size_t nicc_topk_sorted(struct nicc_topk_t *t, void *out, u64 *keys);
+
+#endif /* NICC_TOPK_H */
@@ -0,0 +1,250 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "unrolled_list.h"
+
+struct unrolled_node_t {
+    struct unrolled_node_t *prev;
+    struct unrolled_node_t *next;
+    u32 count;
+    max_align_t data[];
+};
+
+#define NODE_HEADER offsetof(struct unrolled_node_t, data)
+
+void unrolled_list_init(struct unrolled_list_t *ul, u32 T_size)
+{
+    ul->head = NULL;
+    ul->tail = NULL;
+    ul->size = 0;
+    ul->T_size = T_size;
+    ul->spare = NULL;
+
+    size_t bytes = UNROLLED_LIST_NODE_BYTES;
+    if (NODE_HEADER + (size_t)UNROLLED_LIST_MIN_NODE_CAP * T_size > bytes) {
+	bytes = NODE_HEADER + (size_t)UNROLLED_LIST_MIN_NODE_CAP * T_size;
+	bytes = (bytes + UNROLLED_LIST_CACHE_LINE - 1) & ~(size_t)(UNROLLED_LIST_CACHE_LINE - 1);
+    }
+    ul->node_bytes = bytes;
+    ul->node_cap = (u32)((bytes - NODE_HEADER) / T_size);
+}
+
+void unrolled_list_free(struct unrolled_list_t *ul)
+{
+    struct unrolled_node_t *node = ul->head;
+    while (node != NULL) {
+	struct unrolled_node_t *next = node->next;
+	free(node);
+	node = next;
+    }
+    free(ul->spare);
+
+    ul->head = NULL;
+    ul->spare = NULL;
+    ul->tail = NULL;
+    ul->size = 0;
+}
+
+static inline u8 *node_elem(struct unrolled_list_t *ul, struct unrolled_node_t *node, size_t i)
+{
+    return (u8 *)node->data + i * ul->T_size;
+}
+
+/* allocates an empty node and links it in after prev, or first if prev is NULL */
+static struct unrolled_node_t *node_new(struct unrolled_list_t *ul, struct unrolled_node_t *prev)
+{
+    struct unrolled_node_t *node = ul->spare;
+    if (node != NULL)
+	ul->spare = NULL;
+    else
+	node = nicc_internal_aligned_alloc(UNROLLED_LIST_CACHE_LINE, ul->node_bytes);
+
+    node->count = 0;
+    node->prev = prev;
+    node->next = prev != NULL ? prev->next : ul->head;
+    if (node->next != NULL)
+	node->next->prev = node;
+    else
+	ul->tail = node;
+    if (prev != NULL)
+	prev->next = node;
+    else
+	ul->head = node;
+
+    return node;
+}
+
+static void node_unlink(struct unrolled_list_t *ul, struct unrolled_node_t *node)
+{
+    if (node->prev != NULL)
+	node->prev->next = node->next;
+    else
+	ul->head = node->next;
+
+    if (node->next != NULL)
+	node->next->prev = node->prev;
+    else
+	ul->tail = node->prev;
+
+    if (ul->spare == NULL)
+	ul->spare = node;
+    else
+	free(node);
+}
+
+/* finds the node holding idx, skipping whole nodes from the closest end */
+static struct unrolled_node_t *find_node(struct unrolled_list_t *ul, size_t idx, size_t *offset)
+{
+    struct unrolled_node_t *node;
+    if (idx < ul->size / 2) {
+	node = ul->head;
+	while (idx >= node->count) {
+	    idx -= node->count;
+	    node = node->next;
+	}
+    } else {
+	size_t from_back = ul->size - idx;
+	node = ul->tail;
+	while (from_back > node->count) {
+	    from_back -= node->count;
+	    node = node->prev;
+	}
+	idx = node->count - from_back;
+    }
+
+    *offset = idx;
+    return node;
+}
+
+static void node_insert(struct unrolled_list_t *ul, struct unrolled_node_t *node, size_t offset,
+			void *val)
+{
+    memmove(node_elem(ul, node, offset + 1), node_elem(ul, node, offset),
+	    (node->count - offset) * ul->T_size);
+    memcpy(node_elem(ul, node, offset), val, ul->T_size);
+    node->count++;
+    ul->size++;
+}
+
+void unrolled_list_push_back(struct unrolled_list_t *ul, void *val)
+{
+    struct unrolled_node_t *node = ul->tail;
+    if (node == NULL || node->count == ul->node_cap)
+	node = node_new(ul, ul->tail);
+    memcpy(node_elem(ul, node, node->count++), val, ul->T_size);
+    ul->size++;
+}
+
+void unrolled_list_push_front(struct unrolled_list_t *ul, void *val)
+{
+    struct unrolled_node_t *node = ul->head;
+    if (node == NULL || node->count == ul->node_cap)
+	node = node_new(ul, NULL);
+    node_insert(ul, node, 0, val);
+}
+
+bool unrolled_list_insert(struct unrolled_list_t *ul, void *val, size_t idx)
+{
+    if (idx > ul->size)
+	return false;
+
+    if (idx == ul->size) {
+	unrolled_list_push_back(ul, val);
+	return true;
+    }
+
+    size_t offset;
+    struct unrolled_node_t *node = find_node(ul, idx, &offset);
+    if (node->count == ul->node_cap) {
+	/* split: the upper half of the node moves into a new node after it */
+	struct unrolled_node_t *upper = node_new(ul, node);
+	u32 keep = node->count / 2;
+	upper->count = node->count - keep;
+	memcpy(node_elem(ul, upper, 0), node_elem(ul, node, keep), upper->count * ul->T_size);
+	node->count = keep;
+
+	if (offset > keep) {
+	    offset -= keep;
+	    node = upper;
+	}
+    }
+
+    node_insert(ul, node, offset, val);
+    return true;
+}
+
+/* merges next into node if both fit in one node */
+static bool try_merge(struct unrolled_list_t *ul, struct unrolled_node_t *node,
+		      struct unrolled_node_t *next)
+{
+    if (node == NULL || next == NULL || node->count + next->count > ul->node_cap)
+	return false;
+
+    memcpy(node_elem(ul, node, node->count), node_elem(ul, next, 0), next->count * ul->T_size);
+    node->count += next->count;
+    node_unlink(ul, next);
+    return true;
+}
+
+bool unrolled_list_remove(struct unrolled_list_t *ul, size_t idx, void *return_ptr)
+{
+    if (idx >= ul->size)
+	return false;
+
+    size_t offset;
+    struct unrolled_node_t *node = find_node(ul, idx, &offset);
+    if (return_ptr != NULL)
+	memcpy(return_ptr, node_elem(ul, node, offset), ul->T_size);
+
+    memmove(node_elem(ul, node, offset), node_elem(ul, node, offset + 1),
+	    (node->count - offset - 1) * ul->T_size);
+    node->count--;
+    ul->size--;
+
+    if (node->count == 0)
+	node_unlink(ul, node);
+    else if (node->count < ul->node_cap / 2 && !try_merge(ul, node, node->next))
+	try_merge(ul, node->prev, node);
+
+    return true;
+}
+
+bool unrolled_list_pop_back(struct unrolled_list_t *ul, void *return_ptr)
+{
+    if (ul->size == 0)
+	return false;
+    return unrolled_list_remove(ul, ul->size - 1, return_ptr);
+}
+
+bool unrolled_list_pop_front(struct unrolled_list_t *ul, void *return_ptr)
+{
+    return unrolled_list_remove(ul, 0, return_ptr);
+}
+
+void *unrolled_list_get(struct unrolled_list_t *ul, size_t idx)
+{
+    if (idx >= ul->size)
+	return NULL;
+
+    size_t offset;
+    struct unrolled_node_t *node = find_node(ul, idx, &offset);
+    return node_elem(ul, node, offset);
+}
@@ -0,0 +1,74 @@
+/*
+ *  Copyright (C) 2022-2023 Nicolai Brand
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef NICC_UNROLLED_LIST_H
+#define NICC_UNROLLED_LIST_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+#ifdef NICC_TYPEDEF
+typedef struct unrolled_list_t UnrolledList;
+#endif /* NICC_TYPEDEF */
+
+#define UNROLLED_LIST_CACHE_LINE 64
+#define UNROLLED_LIST_NODE_BYTES 256 // node size, grown in cache lines if fewer than 4 elements fit
+#define UNROLLED_LIST_MIN_NODE_CAP 4
+
+struct unrolled_node_t;
+
+/*
+ * Doubly linked list of nodes that each store up to node_cap elements of T_size
+ * bytes inline, so a traversal touches a few contiguous cache lines per node
+ * instead of one allocation per element. A full node is split in two when
+ * inserting into it, and a node that drops below half full is merged with a
+ * neighbour when the two fit in one node. Index based operations skip whole
+ * nodes by their element count, walking from whichever end is closer.
+ * One emptied node is kept as a spare, so pushing and popping across a node
+ * boundary does not allocate and free a node on every call.
+ * Unlike linkedlist_t the elements are copied into the list.
+ */
+struct unrolled_list_t {
+    struct unrolled_node_t *head;
+    struct unrolled_node_t *tail;
+    size_t size;
+    u32 T_size;
+    u32 node_cap; // elements per node
+    size_t node_bytes;
+    struct unrolled_node_t *spare; // unlinked empty node reused by the next node_new, or NULL
+};
+
+void unrolled_list_init(struct unrolled_list_t *ul, u32 T_size);
+void unrolled_list_free(struct unrolled_list_t *ul);
+
+/* amortized O(1) at both ends */
+void unrolled_list_push_back(struct unrolled_list_t *ul, void *val);
+void unrolled_list_push_front(struct unrolled_list_t *ul, void *val);
+
+/* return_ptr may be NULL if the element is not needed */
+bool unrolled_list_pop_back(struct unrolled_list_t *ul, void *return_ptr);
+bool unrolled_list_pop_front(struct unrolled_list_t *ul, void *return_ptr);
+
+/* inserts val so that it ends up at idx, idx may be equal to the size */
+bool unrolled_list_insert(struct unrolled_list_t *ul, void *val, size_t idx);
+bool unrolled_list_remove(struct unrolled_list_t *ul, size_t idx, void *return_ptr);
+
+/* pointer to the element, valid until the next insert or remove */
+void *unrolled_list_get(struct unrolled_list_t *ul, size_t idx);
+
+#endif /* NICC_UNROLLED_LIST_H */